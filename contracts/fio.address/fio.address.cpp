@@ -21,14 +21,19 @@ namespace fioio {
     class [[eosio::contract("FioAddressLookup")]]  FioNameLookup : public eosio::contract {
 
     private:
-        const int MIN_VOTES_FOR_AVERAGING = 15;
+        power_update_sender power_updates;
+        const uint32_t MAX_BURN_REMAINING_COUNT = 100;
         domains_table domains;
         domainsales_table domainsales;
         fionames_table fionames;
+        fionamepubs_table fionamepubs;
+        pubmigrinfo_singleton pubmigrinfos;
         fiofee_table fiofees;
         eosio_names_table accountmap;
         bundlevoters_table bundlevoters;
+        bundleamount_singleton bundleamounts;
         tpids_table tpids;
+        payabletpids_table payabletpids;
         nftburnq_table nftburnqueue;
         eosiosystem::voters_table voters;
         eosiosystem::top_producers_table topprods;
@@ -51,12 +56,16 @@ namespace fioio {
                                                                         domains(_self, _self.value),
                                                                         domainsales(EscrowContract, EscrowContract.value),
                                                                         fionames(_self, _self.value),
+                                                                        fionamepubs(_self, _self.value),
+                                                                        pubmigrinfos(_self, _self.value),
                                                                         fiofees(FeeContract, FeeContract.value),
                                                                         bundlevoters(FeeContract, FeeContract.value),
+                                                                        bundleamounts(FeeContract, FeeContract.value),
                                                                         accountmap(_self, _self.value),
                                                                         nftstable(_self, _self.value),
                                                                         nftburnqueue(get_self(), get_self().value),
                                                                         tpids(TPIDContract, TPIDContract.value),
+                                                                        payabletpids(TPIDContract, TPIDContract.value),
                                                                         voters(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
                                                                         topprods(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
                                                                         producers(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
@@ -234,34 +243,99 @@ namespace fioio {
         }
 
         inline uint64_t getBundledAmount() {
-            int totalcount = 0;
-            vector <uint64_t> votes;
-            uint64_t returnvalue = 0;
+            //use the amount maintained by fio.fee, compute it only until the first bundle vote or schedule change.
+            if (bundleamounts.exists()) {
+                return bundleamounts.get().bundled_transactions;
+            }
+            return compute_bundle_amount(topprods, bundlevoters);
+        }
+
+        //charge step bundled transactions to a fioname in place, fails the transaction if not enough remain.
+        void decrement_bundle(const uint64_t &fionameid, const int32_t &step) {
+            auto fioname_iter = fionames.find(fionameid);
+            if (fioname_iter->bundleeligiblecountdown > step - 1) {
+                fionames.modify(fioname_iter, _self, [&](struct fioname &a) {
+                    a.bundleeligiblecountdown = (fioname_iter->bundleeligiblecountdown - step);
+                });
+            } else
+                check(false, "Failed to decrement eligible bundle counter"); // required to fail the parent transaction
+        }
 
-            if (bundlevoters.end() == bundlevoters.begin()) {
-                return DEFAULTBUNDLEAMT;
+        //remove the payabletpids row of a tpid that is being erased, so tpidclaim does not visit it.
+        inline void remove_payable_tpid(const uint64_t &tpidid) {
+            auto payable_iter = payabletpids.find(tpidid);
+            if (payable_iter != payabletpids.end()) {
+                payabletpids.erase(payable_iter);
             }
+        }
+
+        inline uint64_t tokenchain_hash(const string &token_code, const string &chain_code) {
+            return (uint64_t) string_to_uint128_hash(token_code + ":" + chain_code);
+        }
 
-            for (const auto &itr : topprods) {
-                auto vote_iter = bundlevoters.find(itr.producer.value);
-                if (vote_iter != bundlevoters.end()) {
-                    votes.push_back(vote_iter->bundledbvotenumber);
+        //find the public address mapped to the token and chain code of a fio address, fionamepubs.end() if none.
+        fionamepubs_table::const_iterator find_pub_address(const uint64_t &fionameid, const string &token_code,
+                                                           const string &chain_code) {
+            const uint128_t key = ((uint128_t) fionameid << 64) | tokenchain_hash(token_code, chain_code);
+            auto pubsbynametoken = fionamepubs.get_index<"bynametoken"_n>();
+            for (auto pub_iter = pubsbynametoken.find(key);
+                 pub_iter != pubsbynametoken.end() && pub_iter->by_nametoken() == key; pub_iter++) {
+                if (pub_iter->token_code == token_code && pub_iter->chain_code == chain_code) {
+                    return fionamepubs.iterator_to(*pub_iter);
                 }
             }
+            return fionamepubs.end();
+        }
 
-            size_t size = votes.size();
+        //set the indexed public address for the token and chain code of a fio address, adding the row if needed.
+        void set_pub_address(const uint64_t &fionameid, const tokenpubaddr &tpa, const name &payer) {
+            auto pub_iter = find_pub_address(fionameid, tpa.token_code, tpa.chain_code);
+            if (pub_iter != fionamepubs.end()) {
+                if (pub_iter->public_address != tpa.public_address) {
+                    fionamepubs.modify(pub_iter, payer, [&](struct fionamepub &p) {
+                        p.public_address = tpa.public_address;
+                    });
+                }
+                return;
+            }
 
-            if (size < MIN_VOTES_FOR_AVERAGING) {
-                return DEFAULTBUNDLEAMT;
-            } else if (size >= MIN_VOTES_FOR_AVERAGING) {
-                sort(votes.begin(), votes.end());
-                if (size % 2 == 0) {
-                    return (votes[size / 2 - 1] + votes[size / 2]) / 2;
+            fionamepubs.emplace(payer, [&](struct fionamepub &p) {
+                p.id = fionamepubs.available_primary_key();
+                p.fionameid = fionameid;
+                p.tokenchainhash = tokenchain_hash(tpa.token_code, tpa.chain_code);
+                p.token_code = tpa.token_code;
+                p.chain_code = tpa.chain_code;
+                p.public_address = tpa.public_address;
+            });
+        }
+
+        //remove the indexed public addresses of a fio address, the FIO public address is kept when keepfio is set.
+        void remove_pub_addresses(const uint64_t &fionameid, const bool &keepfio) {
+            auto pubsbynametoken = fionamepubs.get_index<"bynametoken"_n>();
+            auto pub_iter = pubsbynametoken.lower_bound((uint128_t) fionameid << 64);
+            while (pub_iter != pubsbynametoken.end() && pub_iter->fionameid == fionameid) {
+                if (keepfio && pub_iter->token_code == "FIO" && pub_iter->chain_code == "FIO") {
+                    pub_iter++;
                 } else {
-                    return votes[size / 2];
+                    pub_iter = pubsbynametoken.erase(pub_iter);
                 }
             }
-            return DEFAULTBUNDLEAMT;
+        }
+
+        //index the addresses vector of a fioname written before fionamepubs existed, this is done once per fioname.
+        //a fioname with addresses and no fionamepubs rows has not been indexed yet.
+        void index_pub_addresses(const fioname &fn, const name &payer) {
+            if (fn.addresses.empty()) {
+                return;
+            }
+            auto pubsbynametoken = fionamepubs.get_index<"bynametoken"_n>();
+            auto pub_iter = pubsbynametoken.lower_bound((uint128_t) fn.id << 64);
+            if (pub_iter != pubsbynametoken.end() && pub_iter->fionameid == fn.id) {
+                return;
+            }
+            for (const auto &tpa : fn.addresses) {
+                set_pub_address(fn.id, tpa, payer);
+            }
         }
 
         uint32_t fio_address_update(const name &actor, const name &owner, const uint64_t max_fee, const FioAddress &fa,
@@ -352,12 +426,12 @@ namespace fioio {
             fionames.emplace(actor, [&](struct fioname &a) {
                 a.id = id;
                 a.name = fa.fioaddress;
-                a.addresses = pubaddresses;
                 a.namehash = nameHash;
                 a.domain = fa.fiodomain;
                 a.domainhash = domainHash;
                 a.expiration = expiration_time;
                 a.owner_account = owner.value;
+                a.addresses = pubaddresses;
                 a.bundleeligiblecountdown = getBundledAmount();
             });
 
@@ -433,13 +507,14 @@ namespace fioio {
             fio_400_assert(now() <= expiration, "domain", fa.fiodomain, "FIO Domain expired",
                            ErrorDomainExpired);
 
-            tokenpubaddr tempStruct;
+            index_pub_addresses(*fioname_iter, actor);
+            vector <tokenpubaddr> addresses = fioname_iter->addresses;
+
             string token;
             string chaincode;
             string public_address;
 
             for (auto tpa = pubaddresses.begin(); tpa != pubaddresses.end(); ++tpa) {
-                bool wasFound = false;
                 token = tpa->token_code.c_str();
                 chaincode = tpa->chain_code.c_str();
                 public_address = tpa->public_address.c_str();
@@ -454,34 +529,30 @@ namespace fioio {
                                "Invalid public address format",
                                ErrorChainAddressEmpty);
 
-                int idx = 0;
-                for (auto it = fioname_iter->addresses.begin(); it != fioname_iter->addresses.end(); ++it) {
-                    if ((it->token_code == token) && (it->chain_code == chaincode) &&
-                        it->public_address == public_address) {
-                        wasFound = true;
-                        break;
-                    }
-                    idx++;
-                }
+                auto pub_iter = find_pub_address(fioname_iter->id, token, chaincode);
+                const bool wasFound = pub_iter != fionamepubs.end() && pub_iter->public_address == public_address;
                 fio_400_assert(wasFound, "public_address", public_address, "Invalid public address",
                                ErrorInvalidFioNameFormat);
 
-                namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                    a.addresses.erase(a.addresses.begin() + idx);
-                });
-
+                fionamepubs.erase(pub_iter);
+                addresses.erase(std::remove_if(addresses.begin(), addresses.end(), [&](const tokenpubaddr &a) {
+                    return a.token_code == token && a.chain_code == chaincode;
+                }), addresses.end());
             }
 
+            namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
+                a.addresses = addresses;
+            });
+
             uint64_t fee_amount = 0;
 
             //begin new fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(REMOVE_PUB_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REMOVE_PUB_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REMOVE_PUB_ADDRESS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REMOVE_PUB_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const int64_t reg_amount = fee_iter->suf_amount;
@@ -514,10 +585,7 @@ namespace fioio {
                 process_rewards(tpid, reg_amount, get_self(), actor);
 
                 if (reg_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            ("eosio"_n, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
 
@@ -555,42 +623,32 @@ namespace fioio {
             fio_400_assert(now() <= expiration, "domain", fa.fiodomain, "FIO Domain expired",
                            ErrorDomainExpired);
 
-            int idx = 0;
-            bool wasFound = false;
-            for (auto it = fioname_iter->addresses.begin(); it != fioname_iter->addresses.end(); ++it) {
-                if ((it->token_code == "FIO") && (it->chain_code == "FIO")) {
-                    wasFound = true;
-                    break;
-                }
-                idx++;
-            }
+            index_pub_addresses(*fioname_iter, actor);
+            remove_pub_addresses(fioname_iter->id, true);
 
-            if (!wasFound) {//remove em all
-                namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                    a.addresses.clear();
-                });
-            } else {
+            vector <tokenpubaddr> addresses;
+            auto fio_iter = std::find_if(fioname_iter->addresses.begin(), fioname_iter->addresses.end(),
+                                         [](const tokenpubaddr &a) {
+                                             return a.token_code == "FIO" && a.chain_code == "FIO";
+                                         });
+            if (fio_iter != fioname_iter->addresses.end()) {
+                addresses.push_back(*fio_iter);
+            }
+            if (addresses.size() != fioname_iter->addresses.size()) {
                 namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                    a.addresses.erase(a.addresses.begin() + (idx + 1), a.addresses.end());
+                    a.addresses = addresses;
                 });
-
-                if (idx > 0) {
-                    namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                        a.addresses.erase(a.addresses.begin(), a.addresses.begin() + idx);
-                    });
-                }
             }
 
             uint64_t fee_amount = 0;
 
             //begin new fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(REMOVE_ALL_PUB_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REMOVE_ALL_PUB_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REMOVE_ALL_PUB_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REMOVE_ALL_PUB_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const int64_t reg_amount = fee_iter->suf_amount;
@@ -618,10 +676,7 @@ namespace fioio {
                 process_rewards(tpid, reg_amount, get_self(), actor);
 
                 if (reg_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            ("eosio"_n, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
             //handle auto proxy
@@ -660,12 +715,14 @@ namespace fioio {
             fio_400_assert(now() <= expiration, "domain", fa.fiodomain, "FIO Domain expired",
                            ErrorDomainExpired);
 
-            tokenpubaddr tempStruct;
+            index_pub_addresses(*fioname_iter, actor);
+            vector <tokenpubaddr> addresses = fioname_iter->addresses;
+            bool changed = false;
+
             string token;
             string chaincode;
 
             for (auto tpa = pubaddresses.begin(); tpa != pubaddresses.end(); ++tpa) {
-                bool wasFound = false;
                 token = tpa->token_code.c_str();
                 chaincode = tpa->chain_code.c_str();
 
@@ -679,38 +736,30 @@ namespace fioio {
                                "Invalid public address format",
                                ErrorChainAddressEmpty);
 
-                auto it = std::find_if(fioname_iter->addresses.begin(), fioname_iter->addresses.end(),
-                                       find_token(token));
-                if ((it->token_code == token) && (it->chain_code == chaincode)) {
-                    namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                        a.addresses[it - fioname_iter->addresses.begin()].public_address = tpa->public_address;
-                    });
-                    wasFound = true;
-                } else if (it->token_code == token && it->chain_code != chaincode) {
-                    for (auto it = fioname_iter->addresses.begin(); it != fioname_iter->addresses.end(); ++it) {
-                        if ((it->token_code == token) && (it->chain_code == chaincode)) {
-                            namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                                a.addresses[it - fioname_iter->addresses.begin()].public_address = tpa->public_address;
-                            });
-                            wasFound = true;
-                            break;
+                auto pub_iter = find_pub_address(fioname_iter->id, token, chaincode);
+                if (pub_iter != fionamepubs.end()) {
+                    if (pub_iter->public_address != tpa->public_address) {
+                        for (auto &a : addresses) {
+                            if (a.token_code == token && a.chain_code == chaincode) {
+                                a.public_address = tpa->public_address;
+                            }
                         }
+                        changed = true;
                     }
-                }
-
-                if (!wasFound) {
-                    fio_400_assert(fioname_iter->addresses.size() != MAX_SET_ADDRESSES, "token_code", tpa->token_code,
+                } else {
+                    fio_400_assert(addresses.size() < MAX_SET_ADDRESSES, "token_code", tpa->token_code,
                                    "Maximum token codes mapped to single FIO Address reached. Only 200 can be mapped.",
                                    ErrorInvalidFioNameFormat); // Don't forget to set the error amount if/when changing MAX_SET_ADDRESSES
-
-                    tempStruct.public_address = tpa->public_address;
-                    tempStruct.token_code = tpa->token_code;
-                    tempStruct.chain_code = tpa->chain_code;
-
-                    namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
-                        a.addresses.push_back(tempStruct);
-                    });
+                    addresses.push_back(*tpa);
+                    changed = true;
                 }
+                set_pub_address(fioname_iter->id, *tpa, actor);
+            }
+
+            if (changed) {
+                namesbyname.modify(fioname_iter, actor, [&](struct fioname &a) {
+                    a.addresses = addresses;
+                });
             }
 
             uint64_t fee_amount = 0;
@@ -720,13 +769,12 @@ namespace fioio {
             }
 
             //begin new fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(ADD_PUB_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(ADD_PUB_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", ADD_PUB_ADDRESS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", ADD_PUB_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const int64_t reg_amount = fee_iter->suf_amount;
@@ -754,10 +802,7 @@ namespace fioio {
                 process_rewards(tpid, reg_amount, get_self(), actor);
 
                 if (reg_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            ("eosio"_n, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
 
@@ -866,13 +911,12 @@ namespace fioio {
             uint64_t fee_amount = 0;
 
             //begin fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(UPDATE_ENCRYPT_KEY_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(UPDATE_ENCRYPT_KEY_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", UPDATE_ENCRYPT_KEY_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", UPDATE_ENCRYPT_KEY_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const int64_t reg_amount = fee_iter->suf_amount;
@@ -898,10 +942,7 @@ namespace fioio {
                 process_rewards(tpid, reg_amount, get_self(), actor);
 
                 if (reg_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            ("eosio"_n, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
 
@@ -916,7 +957,7 @@ namespace fioio {
 
             updfionminf(encrypt_public_key, FIO_REQUEST_CONTENT_ENCRYPTION_PUB_KEY_DATA_DESC,fioname_iter->id,actor);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", UPDATE_ENCRYPT_KEY_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", UPDATE_ENCRYPT_KEY_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const string response_string = string("{\"status\": \"OK\",\"fee_collected\":") +
@@ -967,11 +1008,10 @@ namespace fioio {
             fioio::convertfiotime(expiration_time, &timeinfo);
             std::string timebuffer = fioio::tmstringformat(timeinfo);
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(REGISTER_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REGISTER_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REGISTER_ADDRESS_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REGISTER_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t reg_amount = fee_iter->suf_amount;
@@ -1036,11 +1076,10 @@ namespace fioio {
             fioio::convertfiotime(expiration_time, &timeinfo);
             std::string timebuffer = fioio::tmstringformat(timeinfo);
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(REGISTER_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REGISTER_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REGISTER_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REGISTER_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t reg_amount = fee_iter->suf_amount;
@@ -1137,15 +1176,17 @@ namespace fioio {
             fio_400_assert(key_iter != accountmap.end(), "owner", to_string(owner_account_name.value),
                            "Owner is not bound in the account map.", ErrorActorNotInFioAccountMap);
 
-            vector <tokenpubaddr> pubaddresses;
             tokenpubaddr t1;
             t1.public_address = key_iter->clientkey;
             t1.token_code = "FIO";
             t1.chain_code = "FIO";
+
+            vector <tokenpubaddr> pubaddresses;
             pubaddresses.push_back(t1);
 
+            const uint64_t fionameid = fionames.available_primary_key();
             fionames.emplace(actor, [&](struct fioname &a) {
-                a.id = fionames.available_primary_key();;
+                a.id = fionameid;
                 a.name = fa.fioaddress;
                 a.addresses = pubaddresses;
                 a.namehash = string_to_uint128_hash(fa.fioaddress.c_str());;
@@ -1155,12 +1196,12 @@ namespace fioio {
                 a.owner_account = owner_account_name.value;
                 a.bundleeligiblecountdown = getBundledAmount();
             });
+            set_pub_address(fionameid, t1, actor);
             
-            const uint128_t endpoint_hash = string_to_uint128_hash(REGISTER_FIO_DOMAIN_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REGISTER_FIO_DOMAIN_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REGISTER_FIO_DOMAIN_ADDRESS_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REGISTER_FIO_DOMAIN_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t reg_amount = fee_iter->suf_amount;
@@ -1235,11 +1276,10 @@ namespace fioio {
                            "FIO domain not found", ErrorDomainNotRegistered);
 
             const uint32_t expiration_time = domains_iter->expiration;
-            const uint128_t endpoint_hash = string_to_uint128_hash(RENEW_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(RENEW_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", RENEW_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", RENEW_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t reg_amount = fee_iter->suf_amount;
@@ -1337,12 +1377,11 @@ namespace fioio {
 
             const uint64_t expiration_time = fioname_iter->expiration;
             const uint64_t bundleeligiblecountdown = fioname_iter->bundleeligiblecountdown;
-            const uint128_t endpoint_hash = string_to_uint128_hash(RENEW_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(RENEW_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", RENEW_ADDRESS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", RENEW_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t reg_amount = fee_iter->suf_amount;
@@ -1422,8 +1461,12 @@ namespace fioio {
 
         /*
          * This action will look for expired domains, then look for expired addresses, it will burn a total
-         * of 25 addresses each time called. please see the code for the logic of identifying expired domains
-         * and addresses.
+         * of 15 items each time called. expired domains are visited in expiration order using the
+         * byexpiration index, burned domains and addresses are removed from the tables so each call
+         * resumes where the previous call stopped without the caller tracking an offset.
+         * the offset parameter is retained for compatibility and is no longer used.
+         * the response reports the number of expired domains still waiting to be burned (counted up to
+         * MAX_BURN_REMAINING_COUNT).
          */
         [[eosio::action]]
         void burnexpired(const uint64_t &offset = 0, const uint32_t &limit = 15) {
@@ -1431,115 +1474,129 @@ namespace fioio {
             if (numbertoburn > 15) { numbertoburn = 15; }
             unsigned int recordProcessed = 0;
             const uint64_t nowtime = now();
-            uint32_t minexpiration = nowtime - DOMAINWAITFORBURNDAYS;
-            uint32_t currentWork = 0;
+            bool domainburned = false;
 
-            uint64_t index = offset;
-            auto domainiter = domains.find(index);
+            auto domainexpidx = domains.get_index<"byexpiration"_n>();
+            auto domainiter = domainexpidx.begin();
 
-            while (domainiter != domains.end()) {
+            while (domainiter != domainexpidx.end()) {
+                domainburned = false;
                 const uint64_t expire = domainiter->expiration;
-                if ((expire + DOMAINWAITFORBURNDAYS) < nowtime) {
-                    name grantor_account = name(domainiter->account);
-                    string permcontrol = grantor_account.to_string() + REGISTER_ADDRESS_ON_DOMAIN_OBJECT_TYPE + domainiter->name + REGISTER_ADDRESS_ON_DOMAIN_PERMISSION_NAME;
-                    const uint128_t permcontrolHash = string_to_uint128_hash(permcontrol.c_str());
-                    auto permissionsbycontrolhash = permissions_table.get_index<"bypermctrl"_n>();
-                    auto permctrl_iter = permissionsbycontrolhash.find(permcontrolHash);
-                    if (permctrl_iter != permissionsbycontrolhash.end() ) {
-                        // clear all the permissions for this domain.
-                        //FIP-40
-                        action(
-                                permission_level{get_self(), "active"_n},
-                                "fio.perms"_n,
-                                "clearperm"_n,
-                                std::make_tuple(grantor_account, REGISTER_ADDRESS_ON_DOMAIN_PERMISSION_NAME, domainiter->name)
-                        ).send();
+                //the index is ordered by expiration, no domain past this one is burnable.
+                if ((expire + DOMAINWAITFORBURNDAYS) >= nowtime) { break; }
+
+                name grantor_account = name(domainiter->account);
+                string permcontrol = grantor_account.to_string() + REGISTER_ADDRESS_ON_DOMAIN_OBJECT_TYPE + domainiter->name + REGISTER_ADDRESS_ON_DOMAIN_PERMISSION_NAME;
+                const uint128_t permcontrolHash = string_to_uint128_hash(permcontrol.c_str());
+                auto permissionsbycontrolhash = permissions_table.get_index<"bypermctrl"_n>();
+                auto permctrl_iter = permissionsbycontrolhash.find(permcontrolHash);
+                if (permctrl_iter != permissionsbycontrolhash.end() ) {
+                    // clear all the permissions for this domain.
+                    //FIP-40
+                    action(
+                            permission_level{get_self(), "active"_n},
+                            "fio.perms"_n,
+                            "clearperm"_n,
+                            std::make_tuple(grantor_account, REGISTER_ADDRESS_ON_DOMAIN_PERMISSION_NAME, domainiter->name)
+                    ).send();
+
+                    // increment the number record processed by one
+                    //this increment helps manage the time used by the burn
+                    recordProcessed++;
+                    if (recordProcessed == numbertoburn) { break; }
+                }
 
-                        // increment the number record processed by one
-                        //this increment helps manage the time used by the burn
-                        recordProcessed++;
-                        if (recordProcessed == numbertoburn) { break; }
+                const auto domainhash = domainiter->domainhash;
+                auto nameexpidx = fionames.get_index<"bydomain"_n>();
+                auto nameiter = nameexpidx.find(domainhash);
+                while (nameiter != nameexpidx.end() && nameiter->domainhash == domainhash) {
+                    auto nextname = nameiter;
+                    nextname++;
+                    const uint64_t burner = nameiter->namehash;
+                    auto tpidbyname = tpids.get_index<"byname"_n>();
+                    auto tpiditer = tpidbyname.find(burner);
+                    auto burnqbyname = nftburnqueue.get_index<"byaddress"_n>();
+                    auto nftburnq_iter = burnqbyname.find(burner);
+
+                    if (nftburnq_iter == burnqbyname.end()) {
+                        nftburnqueue.emplace(SYSTEMACCOUNT, [&](auto &n) {
+                            n.id = nftburnqueue.available_primary_key();
+                            n.fio_address_hash = burner;
+                        });
                     }
 
-                    const auto domainhash = domainiter->domainhash;
-                    auto nameexpidx = fionames.get_index<"bydomain"_n>();
-                    auto nameiter = nameexpidx.find(domainhash);
-                    while (nameiter != nameexpidx.end()) {
-                        auto nextname = nameiter;
-                        nextname++;
-                        if (nameiter->domainhash == domainhash) {
-                            const uint64_t burner = nameiter->namehash;
-                            auto tpidbyname = tpids.get_index<"byname"_n>();
-                            auto tpiditer = tpidbyname.find(burner);
-                            auto burnqbyname = nftburnqueue.get_index<"byaddress"_n>();
-                            auto nftburnq_iter = burnqbyname.find(burner);
-
-                            if (nftburnq_iter == burnqbyname.end()) {
-                                nftburnqueue.emplace(SYSTEMACCOUNT, [&](auto &n) {
-                                    n.id = nftburnqueue.available_primary_key();
-                                    n.fio_address_hash = burner;
-                                });
-                            }
-
-                            if (tpiditer != tpidbyname.end()) { tpidbyname.erase(tpiditer); }
-
-                            auto producersbyaddress = producers.get_index<"byaddress"_n>();
-                            auto prod_iter = producersbyaddress.find(burner);
-                            auto proxybyaddress = voters.get_index<"byaddress"_n>();
-                            auto proxy_iter = proxybyaddress.find(burner);
-
-                            if (proxy_iter != proxybyaddress.end() || prod_iter != producersbyaddress.end()) {
-                                action(
-                                        permission_level{AddressContract, "active"_n},
-                                        "eosio"_n,
-                                        "burnaction"_n,
-                                        std::make_tuple(burner)
-                                ).send();
-                            }
-
-                            nameexpidx.erase(nameiter);
-                            recordProcessed++;
-                        }
-                        if (recordProcessed == numbertoburn) { break; }
-                        nameiter = nextname;
+                    if (tpiditer != tpidbyname.end()) {
+                        remove_payable_tpid(tpiditer->id);
+                        tpidbyname.erase(tpiditer);
                     }
 
-                    if (nameiter == nameexpidx.end()) {
+                    auto producersbyaddress = producers.get_index<"byaddress"_n>();
+                    auto prod_iter = producersbyaddress.find(burner);
+                    auto proxybyaddress = voters.get_index<"byaddress"_n>();
+                    auto proxy_iter = proxybyaddress.find(burner);
+
+                    if (proxy_iter != proxybyaddress.end() || prod_iter != producersbyaddress.end()) {
                         action(
-                                permission_level{get_self(), "active"_n},
-                                "fio.address"_n,
-                                "burndomain"_n,
-                                std::make_tuple(domainiter->name,index)
+                                permission_level{AddressContract, "active"_n},
+                                "eosio"_n,
+                                "burnaction"_n,
+                                std::make_tuple(burner)
                         ).send();
-                        recordProcessed++;
-
-                        // Find any domains listed for sale on the fio.escrow contract table
-                        auto domainsalesbydomain = domainsales.get_index<"bydomain"_n>();
-                        auto domainsaleiter = domainsalesbydomain.find(domainhash);
-                        // if found, call cxburned on fio.escrow
-                        if(domainsaleiter != domainsalesbydomain.end()){
-                            if(domainsaleiter->status == 1) {
-                                action(permission_level{get_self(), "active"_n},
-                                       EscrowContract, "cxburned"_n,
-                                       make_tuple(domainhash)
-                                ).send();
-                            }
-                        }
                     }
 
+                    remove_pub_addresses(nameiter->id, false);
+                    nameexpidx.erase(nameiter);
+                    recordProcessed++;
+                    nameiter = nextname;
                     if (recordProcessed == numbertoburn) { break; }
                 }
-                index++;
-                domainiter = domains.find(index);
-                recordProcessed++;
-                currentWork++;
+
+                //the domain is burned only when its addresses are gone and the burn fits in this call's limit.
+                if ((nameiter == nameexpidx.end() || nameiter->domainhash != domainhash) &&
+                    recordProcessed < numbertoburn) {
+                    action(
+                            permission_level{get_self(), "active"_n},
+                            "fio.address"_n,
+                            "burndomain"_n,
+                            std::make_tuple(domainiter->name, domainiter->id)
+                    ).send();
+                    recordProcessed++;
+                    domainburned = true;
+
+                    // Find any domains listed for sale on the fio.escrow contract table
+                    auto domainsalesbydomain = domainsales.get_index<"bydomain"_n>();
+                    auto domainsaleiter = domainsalesbydomain.find(domainhash);
+                    // if found, call cxburned on fio.escrow
+                    if(domainsaleiter != domainsalesbydomain.end()){
+                        if(domainsaleiter->status == 1) {
+                            action(permission_level{get_self(), "active"_n},
+                                   EscrowContract, "cxburned"_n,
+                                   make_tuple(domainhash)
+                            ).send();
+                        }
+                    }
+                }
+
+                if (recordProcessed >= numbertoburn) { break; }
+                domainburned = false;
+                domainiter++;
             }
 
-            if (currentWork > 0) { recordProcessed -= currentWork; }
             fio_400_assert(recordProcessed != 0, "burnexpired", "burnexpired",
                            "No work.", ErrorNoWork);
+
+            //the last domain sent to burndomain is removed when that inline action runs, do not count it.
+            if (domainburned && domainiter != domainexpidx.end()) { domainiter++; }
+            uint32_t remaining = 0;
+            while (domainiter != domainexpidx.end() && remaining < MAX_BURN_REMAINING_COUNT &&
+                   (domainiter->expiration + DOMAINWAITFORBURNDAYS) < nowtime) {
+                remaining++;
+                domainiter++;
+            }
+
             const string response_string = string("{\"status\": \"OK\",\"items_burned\":") +
-                                           to_string(recordProcessed) + string("}");
+                                           to_string(recordProcessed) + string(",\"domains_remaining\":") +
+                                           to_string(remaining) + string("}");
 
             fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
                            "Transaction is too large", ErrorTransactionTooLarge);
@@ -1807,22 +1864,16 @@ namespace fioio {
             uint64_t fee_amount = 0;
 
             if (fioname_iter->bundleeligiblecountdown > 1) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(fio_address, 2)
-                }.send();
+                decrement_bundle(fioname_iter->id, 2);
 
             } else {
 
-                const uint128_t endpoint_hash = string_to_uint128_hash(ADD_NFT_ENDPOINT);
+                constexpr fee_endpoint endpoint_fee = builtin_fee(ADD_NFT_ENDPOINT);
 
-                auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-                auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+                auto fee_iter = find_fee(fiofees, endpoint_fee);
 
                 //if the fee isnt found for the endpoint, then 400 error.
-                fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", ADD_NFT_ENDPOINT,
+                fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", ADD_NFT_ENDPOINT,
                                "FIO fee not found for endpoint", ErrorNoEndpoint);
 
 
@@ -1840,10 +1891,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), actor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
             //handle auto proxy
@@ -1910,6 +1958,8 @@ namespace fioio {
 
             auto nftbyid = nftstable.get_index<"bytokenid"_n>();
             auto nftbycontract = nftstable.get_index<"bycontract"_n>();
+            auto nftbyaddress = nftstable.get_index<"byaddress"_n>();
+            const uint128_t addressHash = string_to_uint128_hash(fio_address);
 
             uint32_t count_erase = 0;
 
@@ -1952,12 +2002,15 @@ namespace fioio {
 
 					fio_400_assert(contract_iter != nftbycontract.end(), "fio_address", fio_address, "NFT not found",
 					ErrorInvalidValue);
-                    for (auto idx = nftbycontract.begin(); idx != nftbycontract.end(); idx++) {
+                    //only the NFTs mapped to this fio address are candidates, walk the byaddress range for
+                    //the address instead of every NFT on chain.
+                    for (auto idx = nftbyaddress.find(addressHash);
+                         idx != nftbyaddress.end() && idx->fio_address_hash == addressHash; idx++) {
                         //if contract address, token_code match aparam and token_id_hash is 0x0000000 then remove
-                        if(idx->contract_address == nftobj->contract_address && idx->chain_code == nftobj->chain_code &&
-                         idx->token_id_hash == uint128_t() && 
+                        if(idx->token_id_hash == uint128_t() && idx->chain_code == nftobj->chain_code &&
+                         idx->contract_address == nftobj->contract_address &&
                          idx->fio_address == fio_address ) {
-                            idx = nftbycontract.erase(idx);
+                            nftbyaddress.erase(idx);
                             count_erase++;
                             break;
                          }
@@ -1973,22 +2026,16 @@ namespace fioio {
             uint64_t fee_amount = 0;
 
             if (fioname_iter->bundleeligiblecountdown > 1) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(fio_address, 1)
-                }.send();
+                decrement_bundle(fioname_iter->id, 1);
 
             } else {
 
-                const uint128_t endpoint_hash = string_to_uint128_hash(REM_NFT_ENDPOINT);
+                constexpr fee_endpoint endpoint_fee = builtin_fee(REM_NFT_ENDPOINT);
 
-                auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-                auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+                auto fee_iter = find_fee(fiofees, endpoint_fee);
 
                 //if the fee isnt found for the endpoint, then 400 error.
-                fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REM_NFT_ENDPOINT,
+                fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REM_NFT_ENDPOINT,
                                "FIO fee not found for endpoint", ErrorNoEndpoint);
 
 
@@ -2006,10 +2053,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), actor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
             //handle auto proxy
@@ -2076,22 +2120,16 @@ namespace fioio {
             uint64_t fee_amount = 0;
 
             if (fioname_iter->bundleeligiblecountdown > 1) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(fio_address, 1)
-                }.send();
+                decrement_bundle(fioname_iter->id, 1);
 
             } else {
 
-                const uint128_t endpoint_hash = string_to_uint128_hash(REM_ALL_NFTS_ENDPOINT);
+                constexpr fee_endpoint endpoint_fee = builtin_fee(REM_ALL_NFTS_ENDPOINT);
 
-                auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-                auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+                auto fee_iter = find_fee(fiofees, endpoint_fee);
 
                 //if the fee isnt found for the endpoint, then 400 error.
-                fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REM_ALL_NFTS_ENDPOINT,
+                fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REM_ALL_NFTS_ENDPOINT,
                                "FIO fee not found for endpoint", ErrorNoEndpoint);
 
 
@@ -2109,10 +2147,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), actor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {actor, true}
-                            );
+                    queue_power_update(actor, true, _self);
                 }
             }
             //handle auto proxy
@@ -2217,14 +2252,13 @@ namespace fioio {
                 a.is_public = is_public;
             });
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(SET_DOMAIN_PUBLIC);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(SET_DOMAIN_PUBLIC);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             const uint64_t fee_type = fee_iter->type;
             const int64_t reg_amount = fee_iter->suf_amount;
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", SET_DOMAIN_PUBLIC,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", SET_DOMAIN_PUBLIC,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t fee_amount = fee_iter->suf_amount;
@@ -2236,10 +2270,7 @@ namespace fioio {
             process_rewards(tpid, reg_amount, get_self(), actor);
             if (reg_amount > 0) {
                 //MAS-522 remove staking from voting.
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        ("eosio"_n, {{_self, "active"_n}},
-                         {actor, true}
-                        );
+                queue_power_update(actor, true, _self);
             }
 
 
@@ -2320,11 +2351,10 @@ namespace fioio {
                            "FIO Address not registered", ErrorFioNameAlreadyRegistered);
 
             fio_403_assert(fioname_iter->owner_account == actor.value, ErrorSignature);
-            const uint128_t endpoint_hash = string_to_uint128_hash(TRANSFER_ADDRESS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(TRANSFER_ADDRESS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", TRANSFER_ADDRESS_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", TRANSFER_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             string owner_account;
@@ -2357,6 +2387,8 @@ namespace fioio {
                 a.owner_account = nm.value;
                 a.addresses = pubaddresses;
             });
+            remove_pub_addresses(fioname_iter->id, false);
+            set_pub_address(fioname_iter->id, t1, actor);
 
             //FIP-39 begin
             //update the encryption key to use.
@@ -2446,8 +2478,12 @@ namespace fioio {
 
             //do the burn
             const uint64_t bundleeligiblecountdown = fioname_iter->bundleeligiblecountdown;
+            remove_pub_addresses(fioname_iter->id, false);
             namesbyname.erase(fioname_iter);
-            if (tpid_iter != tpid_by_name.end()) { tpid_by_name.erase(tpid_iter); }
+            if (tpid_iter != tpid_by_name.end()) {
+                remove_payable_tpid(tpid_iter->id);
+                tpid_by_name.erase(tpid_iter);
+            }
 
             //FIP-39 begin
             //remove the associated handle information.
@@ -2459,11 +2495,10 @@ namespace fioio {
 
             //fees
             uint64_t fee_amount = 0;
-            const uint128_t endpoint_hash = string_to_uint128_hash("burn_fio_address");
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(BURN_FIO_ADDRESS_ENDPOINT);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", BURN_FIO_ADDRESS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", BURN_FIO_ADDRESS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t fee_type = fee_iter->type;
@@ -2520,11 +2555,10 @@ namespace fioio {
                            "FIO Domain not registered", ErrorDomainNotRegistered);
 
             fio_403_assert(domains_iter->account == actor.value, ErrorSignature);
-            const uint128_t endpoint_hash = string_to_uint128_hash(TRANSFER_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(TRANSFER_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", TRANSFER_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", TRANSFER_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             //Transfer the domain
@@ -2623,10 +2657,9 @@ namespace fioio {
             fio_400_assert(present_time <= domain_expiration, "fio_address", fa.fioaddress, "FIO Domain expired",
                            ErrorDomainExpired);
 
-            const uint128_t endpoint_hash = string_to_uint128_hash("add_bundled_transactions");
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", ADD_BUNDLED_TRANSACTION_ENDPOINT,
+            constexpr fee_endpoint endpoint_fee = builtin_fee(ADD_BUNDLED_TRANSACTION_ENDPOINT);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", ADD_BUNDLED_TRANSACTION_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             //Add bundle
@@ -2675,12 +2708,60 @@ namespace fioio {
             fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
                            "FIO address not registered", ErrorFioNameAlreadyRegistered);
 
-            if (fioname_iter->bundleeligiblecountdown > step - 1) {
-                namesbyname.modify(fioname_iter, _self, [&](struct fioname &a) {
-                    a.bundleeligiblecountdown = (fioname_iter->bundleeligiblecountdown - step);
-                });
-            } else
-                check(false, "Failed to decrement eligible bundle counter"); // required to fail the parent transaction
+            decrement_bundle(fioname_iter->id, step);
+        }
+
+        //the bundle charge sent by charge_bundle, the fioname is found by primary key.
+        [[eosio::action]]
+        void decrbundle(const uint64_t &fionameid, const int32_t &step) {
+
+            check(step > 0, "step must be greater than 0");
+            check((has_auth(AddressContract) || has_auth(TokenContract) || has_auth(TREASURYACCOUNT) || has_auth(STAKINGACCOUNT) ||
+                   has_auth(REQOBTACCOUNT) || has_auth(SYSTEMACCOUNT) || has_auth(FeeContract) || has_auth(PERMSACCOUNT)),
+                  "missing required authority of fio.address, fio.token, fio.fee, fio.treasury, fio.reqobt, fio.system, fio.staking fio.perms");
+
+            fio_400_assert(fionames.find(fionameid) != fionames.end(), "fionameid", to_string(fionameid),
+                           "FIO address not registered", ErrorFioNameAlreadyRegistered);
+
+            decrement_bundle(fionameid, step);
+        }
+
+        /*
+         * This action indexes the public addresses of up to 25 fio addresses from fioname::addresses
+         * into the fionamepubs table, fio addresses are visited in id order starting where the previous
+         * call stopped. fio addresses are also indexed when their public addresses are next changed.
+         * fioname rows are only read, the index rows are paid by fio.address.
+         */
+        [[eosio::action]]
+        void migrpubaddr(const uint16_t &amount, const name &actor) {
+            require_auth(actor);
+
+            auto prodbyowner = producers.get_index<"byowner"_n>();
+            fio_400_assert(prodbyowner.find(actor.value) != prodbyowner.end(), "actor", actor.to_string(),
+                           "Actor not active producer", ErrorNoFioAddressProducer);
+
+            pubmigrinfo migr = pubmigrinfos.get_or_default();
+            fio_400_assert(!migr.finished, "migrpubaddr", "migrpubaddr", "No Work.", ErrorNoWork);
+
+            const uint16_t limit = amount > 25 ? 25 : amount;
+            uint16_t count = 0;
+            auto fioname_iter = fionames.lower_bound(migr.next_id);
+            while (fioname_iter != fionames.end() && count < limit) {
+                index_pub_addresses(*fioname_iter, _self);
+                migr.next_id = fioname_iter->id + 1;
+                count++;
+                fioname_iter++;
+            }
+            migr.finished = fioname_iter == fionames.end();
+            pubmigrinfos.set(migr, _self);
+
+            const string response_string = string("{\"status\": \"OK\",\"migrated\":") +
+                                           to_string(count) + string("}");
+
+            fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
+                           "Transaction is too large", ErrorTransaction);
+
+            send_response(response_string.c_str());
         }
 
         [[eosio::action]]
@@ -2731,6 +2812,6 @@ namespace fioio {
     };
 
     EOSIO_DISPATCH(FioNameLookup,(regaddress)(addaddress)(remaddress)(remalladdr)(regdomain)(renewdomain)(renewaddress)
-    (setdomainpub)(burnexpired)(burndomain)(decrcounter)(bind2eosio)(burnaddress)(xferdomain)(xferaddress)(addbundles)(xferescrow)
-    (addnft)(remnft)(remallnfts)(burnnfts)(regdomadd)(updcryptkey))
+    (setdomainpub)(burnexpired)(burndomain)(decrcounter)(decrbundle)(bind2eosio)(burnaddress)(xferdomain)(xferaddress)(addbundles)(xferescrow)
+    (addnft)(remnft)(remallnfts)(burnnfts)(regdomadd)(updcryptkey)(migrpubaddr))
 }
@@ -96,6 +96,42 @@ namespace fioio {
     >
     fionames_table;
 
+    // an index of the public addresses of a fio address, one row per token and chain code pair.
+    // fioname::addresses stays the authoritative list read by the get_pub_address chain api,
+    // both are written together so lookups and duplicate checks do not scan the vector.
+    // bynametoken is (fionameid << 64 | tokenchainhash), all the addresses of a fioname are the
+    // range [fionameid << 64, (fionameid + 1) << 64).
+    struct [[eosio::action]] fionamepub {
+        uint64_t id = 0;
+        uint64_t fionameid = 0;
+        uint64_t tokenchainhash = 0;
+        string token_code;
+        string chain_code;
+        string public_address;
+
+        uint64_t primary_key() const { return id; }
+        uint128_t by_nametoken() const { return ((uint128_t) fionameid << 64) | tokenchainhash; }
+
+        EOSLIB_SERIALIZE(fionamepub, (id)(fionameid)(tokenchainhash)(token_code)(chain_code)(public_address)
+        )
+    };
+
+    typedef multi_index<"fionamepubs"_n, fionamepub,
+            indexed_by<"bynametoken"_n, const_mem_fun < fionamepub, uint128_t, &fionamepub::by_nametoken>>
+    >
+    fionamepubs_table;
+
+    // progress of the indexing of fioname::addresses into fionamepubs, next_id is the next fioname id to index.
+    struct [[eosio::action]] pubmigrinfo {
+        uint64_t next_id = 0;
+        bool finished = false;
+
+        EOSLIB_SERIALIZE(pubmigrinfo, (next_id)(finished)
+        )
+    };
+
+    typedef singleton<"pubmigrinfo"_n, pubmigrinfo> pubmigrinfo_singleton;
+
     struct [[eosio::action]] domain {
         uint64_t id;
         string name;
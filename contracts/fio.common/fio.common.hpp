@@ -9,6 +9,9 @@
 #pragma once
 
 #include <vector>
+#include <tuple>
+#include <algorithm>
+#include <map>
 #include <string>
 #include <eosiolib/eosio.hpp>
 #include <eosiolib/system.hpp>
@@ -38,6 +41,7 @@
 #define MAXBPS 42
 #define MAXACTIVEBPS 21
 #define DEFAULTBUNDLEAMT 100
+#define MINBUNDLEVOTES 15
 //staking
 #define STAKEDTOKENPOOLMINIMUM 1000000000000000 // 1M FIO SUFS
 #define STAKINGREWARDSRESERVEMAXIMUM 25000000000000000 // 25M FIO SUFS.
@@ -123,6 +127,78 @@ namespace fioio {
         return 0;
     }
 
+    //the median of the bundle votes of the top producers, DEFAULTBUNDLEAMT until MINBUNDLEVOTES of them voted.
+    //fio.fee stores it in the bundleamount singleton, fio.address computes it only until that exists.
+    template<typename TopProds, typename BundleVoters>
+    uint64_t compute_bundle_amount(const TopProds &topprods, const BundleVoters &bundlevoters) {
+        if (bundlevoters.end() == bundlevoters.begin()) {
+            return DEFAULTBUNDLEAMT;
+        }
+
+        vector <uint64_t> votes;
+        for (const auto &itr : topprods) {
+            auto vote_iter = bundlevoters.find(itr.producer.value);
+            if (vote_iter != bundlevoters.end()) {
+                votes.push_back(vote_iter->bundledbvotenumber);
+            }
+        }
+
+        const size_t size = votes.size();
+        if (size < MINBUNDLEVOTES) {
+            return DEFAULTBUNDLEAMT;
+        }
+        sort(votes.begin(), votes.end());
+        if (size % 2 == 0) {
+            return (votes[size / 2 - 1] + votes[size / 2]) / 2;
+        }
+        return votes[size / 2];
+    }
+
+    //updatepower requests made during the present action, in the order they were first made.
+    static vector<tuple<name, bool, name>> pending_power_updates;
+
+    //true once the contract instance holds a power_update_sender.
+    static bool power_update_sender_present = false;
+
+    //request an updatepower for the voter once the present action completes. repeated requests for the
+    //same voter and updateonly flag during one action are coalesced into one updatepower.
+    //updatepower used to be sent where the balance changed. it is now sent after every other inline action
+    //of the action, so those actions read the voting power from before the action and updatepower computes
+    //the final one. a contract queueing updates must hold a power_update_sender, without one the updates
+    //would be dropped silently so the queueing fails instead.
+    inline void queue_power_update(const name &voter, const bool &updateonly, const name &auth) {
+        check(power_update_sender_present, "power update queued without a power_update_sender");
+        for (const auto &pending : pending_power_updates) {
+            if (get<0>(pending) == voter && get<1>(pending) == updateonly) {
+                return;
+            }
+        }
+        pending_power_updates.push_back(make_tuple(voter, updateonly, auth));
+    }
+
+    //send the queued updatepower actions.
+    inline void send_power_updates() {
+        for (const auto &pending : pending_power_updates) {
+            action(permission_level{get<2>(pending), "active"_n},
+                   SYSTEMACCOUNT, "updatepower"_n,
+                   make_tuple(get<0>(pending), get<1>(pending))
+            ).send();
+        }
+        pending_power_updates.clear();
+    }
+
+    //a member of every contract that queues power updates. members are destroyed after the body of the
+    //contract destructor, so the queued updates are sent after any inline action the destructor sends.
+    struct power_update_sender {
+        power_update_sender() {
+            power_update_sender_present = true;
+        }
+
+        ~power_update_sender() {
+            send_power_updates();
+        }
+    };
+
     void fio_fees(const name &actor, const asset &fee, const string &act) {
         if (fee.amount > 0) {
             action(permission_level{SYSTEMACCOUNT, "active"_n},
@@ -132,10 +208,7 @@ namespace fioio {
 
             ).send();
 
-            action(permission_level{SYSTEMACCOUNT, "active"_n},
-                   SYSTEMACCOUNT, "updatepower"_n,
-                   make_tuple(actor, true)
-            ).send();
+            queue_power_update(actor, true, SYSTEMACCOUNT);
         }
     }
 
@@ -200,6 +273,153 @@ namespace fioio {
         return retval;
     }
 
+    //compile time sha1, this is used to hash the endpoint names of the built in fees.
+    struct sha1_digest {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    };
+
+    constexpr uint32_t sha1_rotl(const uint32_t x, const uint32_t n) {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    constexpr uint64_t constexpr_strlen(const char *str) {
+        uint64_t len = 0;
+        while (str[len] != '\0') {
+            len++;
+        }
+        return len;
+    }
+
+    //the byte at pos of the padded message, the message is followed by 0x80, zeros and its length in bits.
+    constexpr uint8_t sha1_message_byte(const char *str, const uint64_t len, const uint64_t total, const uint64_t pos) {
+        if (pos < len) return (uint8_t) str[pos];
+        if (pos == len) return 0x80;
+        if (pos >= total - 8) return (uint8_t) ((len * 8) >> (8 * (total - 1 - pos)));
+        return 0;
+    }
+
+    constexpr sha1_digest constexpr_sha1(const char *str) {
+        const uint64_t len = constexpr_strlen(str);
+        const uint64_t total = ((len + 8) / 64 + 1) * 64;
+        sha1_digest digest{};
+
+        for (uint64_t block = 0; block < total; block += 64) {
+            uint32_t w[80] = {};
+            for (int i = 0; i < 16; i++) {
+                for (int j = 0; j < 4; j++) {
+                    w[i] = (w[i] << 8) | sha1_message_byte(str, len, total, block + i * 4 + j);
+                }
+            }
+            for (int i = 16; i < 80; i++) {
+                w[i] = sha1_rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            }
+
+            uint32_t a = digest.h[0], b = digest.h[1], c = digest.h[2], d = digest.h[3], e = digest.h[4];
+            for (int i = 0; i < 80; i++) {
+                uint32_t f = 0, k = 0;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                const uint32_t temp = sha1_rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = sha1_rotl(b, 30);
+                b = a;
+                a = temp;
+            }
+            digest.h[0] += a;
+            digest.h[1] += b;
+            digest.h[2] += c;
+            digest.h[3] += d;
+            digest.h[4] += e;
+        }
+        return digest;
+    }
+
+    //the compile time equivalent of string_to_uint128_hash. checksum160 packs the first 16 bytes of the
+    //digest big endian into its first word, which is the word string_to_uint128_hash copies out.
+    constexpr uint128_t endpoint_hash(const char *end_point) {
+        const sha1_digest digest = constexpr_sha1(end_point);
+        return ((uint128_t) digest.h[0] << 96) | ((uint128_t) digest.h[1] << 64) |
+               ((uint128_t) digest.h[2] << 32) | (uint128_t) digest.h[3];
+    }
+
+    static_assert(endpoint_hash("") ==
+                  (((uint128_t) 0xda39a3ee5e6b4b0dULL << 64) | 0x3255bfef95601890ULL), "sha1 mismatch");
+    static_assert(endpoint_hash("abc") ==
+                  (((uint128_t) 0xa9993e364706816aULL << 64) | 0xba3e25717850c26cULL), "sha1 mismatch");
+    static_assert(endpoint_hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+                  (((uint128_t) 0x84983e441c3bd26eULL << 64) | 0xbaae4aa1f95129e5ULL), "sha1 mismatch");
+
+    //the endpoints of the built in fees. the position of an endpoint in this list is the fixed fee_id of
+    //its fee, createfee uses it when the id is free so the fee can be read by primary key. append only.
+    static constexpr const char *BUILTIN_FEE_ENDPOINTS[] = {
+            REGISTER_DOMAIN_ENDPOINT, REGISTER_ADDRESS_ENDPOINT, RENEW_DOMAIN_ENDPOINT, RENEW_ADDRESS_ENDPOINT,
+            ADD_PUB_ADDRESS_ENDPOINT, TRANSFER_TOKENS_PUBKEY_ENDPOINT, NEW_FUNDS_REQUEST_ENDPOINT,
+            REJECT_FUNDS_REQUEST_ENDPOINT, RECORD_OBT_DATA_ENDPOINT, SET_DOMAIN_PUBLIC,
+            REGISTER_PRODUCER_ENDPOINT, REGISTER_PROXY_ENDPOINT, UNREGISTER_PROXY_ENDPOINT,
+            UNREGISTER_PRODUCER_ENDPOINT, VOTE_PROXY_ENDPOINT, VOTE_PRODUCER_ENDPOINT,
+            SUBMIT_BUNDLED_TRANSACTION_ENDPOINT, SUBMIT_FEE_MULTIPLER_ENDPOINT, SUBMIT_FEE_RATIOS_ENDPOINT,
+            BURN_FIO_ADDRESS_ENDPOINT, CANCEL_FUNDS_REQUEST_ENDPOINT, REMOVE_PUB_ADDRESS_ENDPOINT,
+            REMOVE_ALL_PUB_ENDPOINT, TRANSFER_DOMAIN_ENDPOINT, TRANSFER_ADDRESS_ENDPOINT,
+            ADD_BUNDLED_TRANSACTION_ENDPOINT, TRANSFER_LOCKED_TOKENS_ENDPOINT, ADD_NFT_ENDPOINT, REM_NFT_ENDPOINT,
+            REM_ALL_NFTS_ENDPOINT, STAKE_FIO_TOKENS_ENDPOINT, UNSTAKE_FIO_TOKENS_ENDPOINT,
+            WRAP_FIO_TOKENS_ENDPOINT, WRAP_FIO_DOMAIN_ENDPOINT, ADD_PERMISSION_ENDPOINT, REMOVE_PERMISSION_ENDPOINT,
+            UPDATE_ENCRYPT_KEY_ENDPOINT, NEW_FIO_CHAIN_ACCOUNT_ENDPOINT, LIST_DOMAIN_ENDPOINT,
+            CANCEL_LIST_DOMAIN_ENDPOINT, BUY_DOMAIN_ENDPOINT, SET_MARKETPLACE_CONFIG_ENDPOINT,
+            REGISTER_FIO_DOMAIN_ADDRESS_ENDPOINT, AUDIT_VOTE_FEE_ENDPOINT
+    };
+    static constexpr uint64_t NO_FIXED_FEE_ID = UINT64_MAX;
+
+    constexpr bool constexpr_streq(const char *a, const char *b) {
+        while (*a != '\0' && *a == *b) {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    //the endpoint hash and fixed fee_id of a fee, fee_id is NO_FIXED_FEE_ID for endpoints that are not built in.
+    struct fee_endpoint {
+        uint128_t hash = 0;
+        uint64_t fee_id = NO_FIXED_FEE_ID;
+    };
+
+    constexpr fee_endpoint builtin_fee(const char *end_point) {
+        fee_endpoint endpoint{endpoint_hash(end_point), NO_FIXED_FEE_ID};
+        for (uint64_t i = 0; i < sizeof(BUILTIN_FEE_ENDPOINTS) / sizeof(BUILTIN_FEE_ENDPOINTS[0]); i++) {
+            if (constexpr_streq(BUILTIN_FEE_ENDPOINTS[i], end_point)) {
+                endpoint.fee_id = i;
+                break;
+            }
+        }
+        return endpoint;
+    }
+
+    //find the fee row of an endpoint. built in fees are read by their fixed fee_id, the byendpoint index
+    //is only used when the row at that id belongs to another endpoint (fees created before the id was fixed).
+    inline fiofee_table::const_iterator find_fee(const fiofee_table &fees, const fee_endpoint &endpoint) {
+        if (endpoint.fee_id != NO_FIXED_FEE_ID) {
+            auto fee_iter = fees.find(endpoint.fee_id);
+            if (fee_iter != fees.end() && fee_iter->end_point_hash == endpoint.hash) {
+                return fee_iter;
+            }
+        }
+        auto fees_by_endpoint = fees.get_index<"byendpoint"_n>();
+        auto fee_iter = fees_by_endpoint.find(endpoint.hash);
+        return fee_iter == fees_by_endpoint.end() ? fees.end() : fees.iterator_to(*fee_iter);
+    }
+
     //use this for debug to see the value of your uint128_t, this will match what shows in get table.
     static std::string to_hex(const char *d, uint32_t s) {
         std::string r;
@@ -263,6 +483,23 @@ namespace fioio {
 
     typedef singleton<"fdtnrewards"_n, fdtnreward> fdtnrewards_table;
 
+    // @abi table rewardaccum i64
+    //the block producer, bucket pool and foundation fee splits and the tpid bounty to mint accrue here
+    //with a single inline action per fee, fio.treasury folds them into bprewards, bpbucketpool and
+    //fdtnrewards and mints the bounty when settled.
+    struct [[eosio::action]] rewardaccum {
+
+        uint64_t bprewards = 0;
+        uint64_t bppool = 0;
+        uint64_t fdtnrewards = 0;
+        uint64_t bounty = 0;
+
+        EOSLIB_SERIALIZE(rewardaccum, (bprewards)(bppool)(fdtnrewards)(bounty)
+        )
+    };
+
+    typedef singleton<"rewardaccum"_n, rewardaccum> rewardaccum_table;
+
     // @abi table bounties i64
     struct [[eosio::action]] bounty {
 
@@ -295,21 +532,171 @@ namespace fioio {
         }
     }
 
-    void process_rewards(const string &tpid, const uint64_t &amount, const name &auth, const name &actor) {
-
+    //accrue the block producer, bucket pool and foundation shares of a fee and the tpid bounty to mint in
+    //fio.treasury, fio.treasury must sign for the bounty as it did for mintfio.
+    inline void accrue_rewards(const name &auth, const uint64_t &bpamount, const uint64_t &bppoolamount,
+                               const uint64_t &fdtnamount, const uint64_t &bountyamount = 0) {
+        std::vector<permission_level> accrauth{{auth, "active"_n}};
+        if (bountyamount > 0 && auth != TREASURYACCOUNT) {
+            accrauth.push_back({TREASURYACCOUNT, "active"_n});
+        }
         action(
-                permission_level{auth, "active"_n},
+                accrauth,
                 TREASURYACCOUNT,
-                "fdtnrwdupdat"_n,
-                std::make_tuple((uint64_t)(static_cast<double>(amount) * .05))
+                "accrrewards"_n,
+                std::make_tuple(bpamount, bppoolamount, fdtnamount, bountyamount)
         ).send();
+    }
 
-        //call action to check general locks for clearing.
+    //charge bundled transactions to the fio address with the given fioname id. the caller has already
+    //resolved the fioname and checked that it holds at least step bundles. only fio.address may write
+    //the fionames table, decrbundle decrements the row by primary key without re-hashing the fio address.
+    inline void charge_bundle(const name &auth, const uint64_t &fionameid, const int32_t &step) {
         action(
                 permission_level{auth, "active"_n},
-                SYSTEMACCOUNT, "clrgenlocked"_n,
-                make_tuple(actor)
+                AddressContract,
+                "decrbundle"_n,
+                std::make_tuple(fionameid, step)
         ).send();
+    }
+
+    //a fio address with its fionames and domains rows resolved. found and domain_found tell whether the
+    //rows exist, the remaining fields are copied from them. callers keep their own error handling.
+    struct resolved_address {
+        uint128_t namehash = 0;
+        uint128_t domainhash = 0;
+        string fiodomain = "";
+        bool found = false;
+        uint64_t fionameid = 0;
+        uint64_t owner = 0;
+        uint64_t expiration = 0;
+        uint64_t bundleeligiblecountdown = 0;
+        bool domain_found = false;
+        uint64_t domain_expiration = 0;
+        bool key_found = false;
+        string encrypt_key = "";
+    };
+
+    //fio addresses resolved during the present action, keyed by the address as given.
+    static std::map<string, resolved_address> resolved_addresses;
+
+    //resolve a fio address once per action. the address is hashed as given, the domain is hashed in
+    //lower case. an action that changes the owner or expiration of an address or domain after resolving
+    //it must call forget_fio_address, bundles are only charged through inline actions so they cannot
+    //change during the action.
+    //fio.address does not use the resolver, it writes the fionames and domains rows it reads and needs
+    //the iterators to modify them. lookups of a bare domain (fio.escrow, the domain actions of fio.oracle)
+    //also read the domains table directly, the resolver is keyed by fio address and does not carry the
+    //domain owner.
+    inline const resolved_address &resolve_fio_address(const string &fio_address) {
+        auto cached = resolved_addresses.find(fio_address);
+        if (cached != resolved_addresses.end()) {
+            return cached->second;
+        }
+
+        FioAddress fa;
+        getFioAddressStruct(fio_address, fa);
+
+        resolved_address ra;
+        ra.namehash = string_to_uint128_hash(fio_address.c_str());
+        ra.domainhash = string_to_uint128_hash(fa.fiodomain.c_str());
+        ra.fiodomain = fa.fiodomain;
+
+        fionames_table fionames(AddressContract, AddressContract.value);
+        auto namesbyname = fionames.get_index<"byname"_n>();
+        auto fioname_iter = namesbyname.find(ra.namehash);
+        if (fioname_iter != namesbyname.end()) {
+            ra.found = true;
+            ra.fionameid = fioname_iter->id;
+            ra.owner = fioname_iter->owner_account;
+            ra.expiration = fioname_iter->expiration;
+            ra.bundleeligiblecountdown = fioname_iter->bundleeligiblecountdown;
+        }
+
+        domains_table domains(AddressContract, AddressContract.value);
+        auto domainsbyname = domains.get_index<"byname"_n>();
+        auto domain_iter = domainsbyname.find(ra.domainhash);
+        if (domain_iter != domainsbyname.end()) {
+            ra.domain_found = true;
+            ra.domain_expiration = domain_iter->expiration;
+        }
+
+        return resolved_addresses.emplace(fio_address, ra).first->second;
+    }
+
+    inline void forget_fio_address(const string &fio_address) {
+        resolved_addresses.erase(fio_address);
+    }
+
+    //the request content encryption key of a fio name, taken from its fionameinfo row or from the
+    //client key of the owning account when the fio name has none.
+    inline string get_encrypt_key(const uint64_t fionameid, const uint64_t acct) {
+        fionameinfo_table fionameinfo(AddressContract, AddressContract.value);
+        auto fionameinfobynameid = fionameinfo.get_index<"byfionameid"_n>();
+        auto fionameinfo_iter = fionameinfobynameid.find(fionameid);
+        if (fionameinfo_iter == fionameinfobynameid.end()) {
+            eosio_names_table clientkeys(AddressContract, AddressContract.value);
+            auto account_iter = clientkeys.find(acct);
+            fio_400_assert(account_iter != clientkeys.end(), "acct", to_string(acct),
+                           "No client key found for account in account map",
+                           ErrorClientKeyNotFound);
+            return account_iter->clientkey;
+        }
+
+        //now check for multiples. no duplicates permitted in table.
+        int countem = 0;
+        string retval = "";
+        while (fionameinfo_iter != fionameinfobynameid.end()) {
+            if ((fionameinfo_iter->datadesc.compare(FIO_REQUEST_CONTENT_ENCRYPTION_PUB_KEY_DATA_DESC) == 0) &&
+                (fionameinfo_iter->fionameid == fionameid)) {
+                retval = fionameinfo_iter->datavalue;
+                countem++;
+            } else if (fionameinfo_iter->fionameid != fionameid) {
+                break;
+            }
+            fionameinfo_iter++;
+        }
+        fio_400_assert(countem == 1, "datadesc", FIO_REQUEST_CONTENT_ENCRYPTION_PUB_KEY_DATA_DESC,
+                       "handle info error -- multiple data values present for datadesc ",
+                       ErrorInvalidValue);
+        return retval;
+    }
+
+    //the encryption key of a registered fio address, read once per action along with the address.
+    inline const string &resolve_encrypt_key(const string &fio_address) {
+        resolve_fio_address(fio_address);
+        resolved_address &ra = resolved_addresses[fio_address];
+        if (!ra.key_found) {
+            ra.encrypt_key = get_encrypt_key(ra.fionameid, ra.owner);
+            ra.key_found = true;
+        }
+        return ra.encrypt_key;
+    }
+
+    void process_rewards(const string &tpid, const uint64_t &amount, const name &auth, const name &actor) {
+
+        const uint64_t fdtnamount = (uint64_t)(static_cast<double>(amount) * .05);
+
+        //call action to clear the general lock once its final locking period is in the past, the same test
+        //clrgenlocked makes. locks written before final_unlock was recorded take it from their last period.
+        eosiosystem::general_locks_table_v2 generallocks(SYSTEMACCOUNT, SYSTEMACCOUNT.value);
+        auto locks_by_owner = generallocks.get_index<"byowner"_n>();
+        auto lockiter = locks_by_owner.find(actor.value);
+        if (lockiter != locks_by_owner.end()) {
+            uint32_t finalunlock = 0;
+            if (lockiter->final_unlock.has_value()) {
+                finalunlock = lockiter->final_unlock.value();
+            } else if (lockiter->periods.size() > 0) {
+                finalunlock = lockiter->timestamp + lockiter->periods[lockiter->periods.size() - 1].duration;
+            }
+            if (finalunlock < now()) {
+                action(
+                        permission_level{auth, "active"_n},
+                        SYSTEMACCOUNT, "clrgenlocked"_n,
+                        make_tuple(actor)
+                ).send();
+            }
+        }
 
 
         fionames_table fionames(AddressContract, AddressContract.value);
@@ -323,36 +710,24 @@ namespace fioio {
             bounties_table bounties(TPIDContract, TPIDContract.value);
             uint64_t bamount = 0;
 
+            //the bounty is minted when the accrued rewards are settled.
             if (bounties.get().tokensminted < MAXBOUNTYTOKENSTOMINT) {
                 bamount = (uint64_t)(static_cast<double>(amount) * .40);
-
-                action(permission_level{TREASURYACCOUNT, "active"_n},
-                       TokenContract, "mintfio"_n,
-                       make_tuple(TREASURYACCOUNT, bamount)
-                ).send();
-
-                action(
-                        permission_level{TREASURYACCOUNT, "active"_n},
-                        TPIDContract,
-                        "updatebounty"_n,
-                        std::make_tuple(bamount)
-                ).send();
-
             }
 
+            // one action records both the tpid reward and the minted bounty, fio.treasury must sign for the bounty.
+            std::vector<permission_level> tpidauth{{auth, "active"_n}};
+            if (bamount > 0 && auth != TREASURYACCOUNT) {
+                tpidauth.push_back({TREASURYACCOUNT, "active"_n});
+            }
             action(
-                    permission_level{auth, "active"_n},
+                    tpidauth,
                     TPIDContract,
-                    "updatetpid"_n,
-                    std::make_tuple(tpid, actor, (amount / 10) + bamount)
+                    "rewardtpid"_n,
+                    std::make_tuple(tpid, actor, (amount / 10) + bamount, bamount)
             ).send();
 
-            action(
-                    permission_level{auth, "active"_n},
-                    TREASURYACCOUNT,
-                    "bprewdupdate"_n,
-                    std::make_tuple((uint64_t)(static_cast<double>(amount) * .60))
-            ).send();
+            accrue_rewards(auth, (uint64_t)(static_cast<double>(amount) * .60), 0, fdtnamount, bamount);
             action(
                     permission_level{auth, "active"_n},
                     STAKINGACCOUNT,
@@ -361,12 +736,7 @@ namespace fioio {
             ).send();
 
         } else {
-            action(
-                    permission_level{auth, "active"_n},
-                    TREASURYACCOUNT,
-                    "bprewdupdate"_n,
-                    std::make_tuple((uint64_t)(static_cast<double>(amount) * .70))
-            ).send();
+            accrue_rewards(auth, (uint64_t)(static_cast<double>(amount) * .70), 0, fdtnamount);
             action(
                     permission_level{auth, "active"_n},
                     STAKINGACCOUNT,
@@ -379,12 +749,7 @@ namespace fioio {
 
     void processbucketrewards(const string &tpid, const uint64_t &amount, const name &auth, const name &actor) {
 
-        action(
-                permission_level{auth, "active"_n},
-                TREASURYACCOUNT,
-                "fdtnrwdupdat"_n,
-                std::make_tuple((uint64_t)(static_cast<double>(amount) * .05))
-        ).send();
+        const uint64_t fdtnamount = (uint64_t)(static_cast<double>(amount) * .05);
 
         fionames_table fionames(AddressContract, AddressContract.value);
         uint128_t fioaddhash = string_to_uint128_hash(tpid.c_str());
@@ -396,36 +761,25 @@ namespace fioio {
             bounties_table bounties(TPIDContract, TPIDContract.value);
             uint64_t bamount = 0;
 
+            //the bounty is minted when the accrued rewards are settled.
             if (bounties.get().tokensminted < MAXBOUNTYTOKENSTOMINT) {
                 bamount = (uint64_t)(static_cast<double>(amount) * .40);
-                action(permission_level{TREASURYACCOUNT, "active"_n},
-                       TokenContract, "mintfio"_n,
-                       make_tuple(TREASURYACCOUNT, bamount)
-                ).send();
-
-                action(
-                        permission_level{TREASURYACCOUNT, "active"_n},
-                        TPIDContract,
-                        "updatebounty"_n,
-                        std::make_tuple(bamount)
-                ).send();
-
             }
 
+            // one action records both the tpid reward and the minted bounty, fio.treasury must sign for the bounty.
+            std::vector<permission_level> tpidauth{{auth, "active"_n}};
+            if (bamount > 0 && auth != TREASURYACCOUNT) {
+                tpidauth.push_back({TREASURYACCOUNT, "active"_n});
+            }
             action(
-                    permission_level{auth, "active"_n},
+                    tpidauth,
                     TPIDContract,
-                    "updatetpid"_n,
-                    std::make_tuple(tpid, actor, (amount / 10) + bamount)
+                    "rewardtpid"_n,
+                    std::make_tuple(tpid, actor, (amount / 10) + bamount, bamount)
             ).send();
 
 
-            action(
-                    permission_level{auth, "active"_n},
-                    TREASURYACCOUNT,
-                    "bppoolupdate"_n,
-                    std::make_tuple((uint64_t)(static_cast<double>(amount) * .60))
-            ).send();
+            accrue_rewards(auth, 0, (uint64_t)(static_cast<double>(amount) * .60), fdtnamount, bamount);
             action(
                     permission_level{auth, "active"_n},
                     STAKINGACCOUNT,
@@ -434,12 +788,7 @@ namespace fioio {
             ).send();
         } else {
 
-            action(
-                    permission_level{auth, "active"_n},
-                    TREASURYACCOUNT,
-                    "bppoolupdate"_n,
-                    std::make_tuple((uint64_t)(static_cast<double>(amount) * .70))
-            ).send();
+            accrue_rewards(auth, 0, (uint64_t)(static_cast<double>(amount) * .70), fdtnamount);
             action(
                     permission_level{auth, "active"_n},
                     STAKINGACCOUNT,
@@ -454,25 +803,14 @@ namespace fioio {
     //Postcondition: the foundation has been rewarded 5% of the transaction fee and top 21/active block producers rewarded 95% of the transaction fee
     void processrewardsnotpid(const uint64_t &amount, const name &actor) {
 
-        action(
-                permission_level{actor, "active"_n},
-                TREASURYACCOUNT,
-                "bprewdupdate"_n,
-                std::make_tuple((uint64_t)(static_cast<double>(amount) * .70))
-        ).send();
+        accrue_rewards(actor, (uint64_t)(static_cast<double>(amount) * .70), 0,
+                       (uint64_t)(static_cast<double>(amount) * .05));
         action(
                 permission_level{actor, "active"_n},
                 STAKINGACCOUNT,
                 "incgrewards"_n,
                 std::make_tuple((uint64_t)(static_cast<double>(amount) * .25))
         ).send();
-
-        action(
-                permission_level{actor, "active"_n},
-                TREASURYACCOUNT,
-                "fdtnrwdupdat"_n,
-                std::make_tuple((uint64_t)(static_cast<double>(amount) * .05))
-        ).send();
     }
 
     inline bool isPubKeyValid(const string &pubkey) {
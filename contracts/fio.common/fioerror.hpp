@@ -236,11 +236,22 @@ namespace fioio {
       throw  eosio::chain::eosio_assert_code_exception(code, "message", fioio::Code_404_Result(message).to_json().c_str()); \
    FC_MULTILINE_MACRO_END
 
+// the json payload and the field value arguments are only evaluated when the test fails,
+// a passing check costs nothing more than the test itself.
 #define fio_400_assert(test, fieldname, fieldvalue, fielderror, code) \
-   eosio_assert_message_code(test, fioio::Code_400_Result(fieldname, fieldvalue, fielderror).to_json().c_str(), code)
+   do { \
+      if (!(test)) \
+         eosio_assert_message_code(false, fioio::Code_400_Result(fieldname, fieldvalue, fielderror).to_json().c_str(), code); \
+   } while (0)
 
 #define fio_403_assert(test, code) \
-   eosio_assert_message_code(test, fioio::Code_403_Result(code).to_json().c_str(), code)
+   do { \
+      if (!(test)) \
+         eosio_assert_message_code(false, fioio::Code_403_Result(code).to_json().c_str(), code); \
+   } while (0)
 
 #define fio_404_assert(test, message, code) \
-   eosio_assert_message_code(test, fioio::Code_404_Result(message).to_json().c_str(), code)
+   do { \
+      if (!(test)) \
+         eosio_assert_message_code(false, fioio::Code_404_Result(message).to_json().c_str(), code); \
+   } while (0)
@@ -17,6 +17,7 @@ namespace fioio {
 
     class [[eosio::contract("FioEscrow")]] FioEscrow : public eosio::contract {
     private:
+        power_update_sender power_updates;
         domainsales_table  domainsales;
         mrkplconfigs_table mrkplconfigs;
         domains_table      domains;
@@ -130,11 +131,10 @@ namespace fioio {
             auto domainsale_id = listdomain_update(actor, fio_domain, domainHash,
                                                    sale_price, marketplace_iter->commission_fee);
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(LIST_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(LIST_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter         = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", LIST_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", LIST_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             //fees
@@ -232,11 +232,10 @@ namespace fioio {
                     std::make_tuple(fio_domain, owner->clientkey, isTransferToEscrow, actor)
             ).send();
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(CANCEL_LIST_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(CANCEL_LIST_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter         = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", CANCEL_LIST_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", CANCEL_LIST_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             //fees
@@ -342,10 +341,7 @@ namespace fioio {
                 ).send();
 
                 //voting power, update domain sale owner
-                action(permission_level{get_self(), "active"_n},
-                       SYSTEMACCOUNT, "updatepower"_n,
-                       make_tuple(name(domainsale_iter->owner), true)
-                ).send();
+                queue_power_update(name(domainsale_iter->owner), true, get_self());
 
             }
 
@@ -360,11 +356,10 @@ namespace fioio {
 
             domainsales.erase(domainsale_iter);
 
-            const uint128_t endpoint_hash = string_to_uint128_hash(LIST_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(LIST_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter         = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", LIST_DOMAIN_ENDPOINT,
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", LIST_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             //fees
@@ -477,11 +472,10 @@ namespace fioio {
             if (!isMsig) {
 
                 //fees
-                const uint128_t endpoint_hash = string_to_uint128_hash(SET_MARKETPLACE_CONFIG_ENDPOINT);
+                constexpr fee_endpoint endpoint_fee = builtin_fee(SET_MARKETPLACE_CONFIG_ENDPOINT);
 
-                auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-                auto fee_iter         = fees_by_endpoint.find(endpoint_hash);
-                fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", SET_MARKETPLACE_CONFIG_ENDPOINT,
+                auto fee_iter = find_fee(fiofees, endpoint_fee);
+                fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", SET_MARKETPLACE_CONFIG_ENDPOINT,
                                "FIO fee not found for endpoint", ErrorNoEndpoint);
 
                 const uint64_t fee_amount = fee_iter->suf_amount;
@@ -28,11 +28,15 @@ namespace fioio {
     class [[eosio::contract("FioFee")]]  FioFee : public eosio::contract {
 
     private:
+        power_update_sender power_updates;
         const int MIN_FEE_VOTERS_FOR_MEDIAN = 15;
         fiofee_table fiofees;
         feevoters_table feevoters;
         bundlevoters_table bundlevoters;
+        bundleamount_singleton bundleamounts;
         feevotes2_table feevotes;
+        feepending_table feependings;
+        feequeuestate_singleton feequeuestates;
         eosiosystem::top_producers_table topprods;
         eosiosystem::producers_table prods;
 
@@ -49,67 +53,116 @@ namespace fioio {
             return topprods;
         }
 
+        //check that the actor is one of the top 150 producers. producers in the ranking snapshot kept by
+        //fio.system are accepted while still active and voted, the others are ranked by getTopProds.
+        bool isTopProd(const name &actor) {
+            eosiosystem::producer_ranking_singleton prodranking(SYSTEMACCOUNT, SYSTEMACCOUNT.value);
+            if (prodranking.exists()) {
+                const auto ranking = prodranking.get();
+                for (const auto &rank : ranking.producers) {
+                    if (rank.owner == actor) {
+                        auto prodbyowner = prods.get_index<"byowner"_n>();
+                        auto prod_iter = prodbyowner.find(actor.value);
+                        if (prod_iter != prodbyowner.end() && prod_iter->active() && 0 < prod_iter->total_votes) {
+                            return true;
+                        }
+                        break;
+                    }
+                }
+            }
+            vector<name> top_prods = getTopProds();
+            return std::find(top_prods.begin(), top_prods.end(), actor) != top_prods.end();
+        }
+
+        //store the present bundle amount, only write the singleton when the amount changes.
+        void update_bundle_amount() {
+            const uint64_t amount = compute_bundle_amount(topprods, bundlevoters);
+            if (!bundleamounts.exists() || bundleamounts.get().bundled_transactions != amount) {
+                bundleamounts.set(bundleamount{amount, (uint64_t) now()}, _self);
+            }
+        }
+
+        //add the fee to the computefees work queue if it is not already queued.
+        void queue_pending_fee(const uint64_t &fee_id) {
+            if (feependings.find(fee_id) == feependings.end()) {
+                feependings.emplace(_self, [&](struct feepending &fp) {
+                    fp.fee_id = fee_id;
+                });
+            }
+        }
+
+        //one time load of the fees flagged votes_pending before the work queue was introduced.
+        void seed_pending_fees() {
+            feequeuestate state = feequeuestates.get_or_default();
+            if (state.seeded) {
+                return;
+            }
+            for (auto fee = fiofees.begin(); fee != fiofees.end(); fee++) {
+                if (fee->votes_pending.value()) {
+                    queue_pending_fee(fee->fee_id);
+                }
+            }
+            state.seeded = true;
+            feequeuestates.set(state, _self);
+        }
+
         uint32_t update_fees() {
-            vector<uint64_t> fee_ids; //hashes for endpoints to process.
+            vector<uint64_t> fee_ids; //ids of the fees to process.
 
             int NUMBER_FEES_TO_PROCESS = 10;
 
-            //get the fees needing processing.
-            auto fee = fiofees.begin();
-            while (fee != fiofees.end()) {
-                if(fee->votes_pending.value()){
-                    fee_ids.push_back(fee->fee_id);
-                    //only get the specified number of fees to process.
-                    if (fee_ids.size() == NUMBER_FEES_TO_PROCESS){
-                        break;
-                    }
-                }
-                fee++;
+            seed_pending_fees();
+
+            //get the fees needing processing from the work queue.
+            for (auto pending = feependings.begin(); pending != feependings.end() &&
+                 fee_ids.size() < NUMBER_FEES_TO_PROCESS; pending++) {
+                fee_ids.push_back(pending->fee_id);
             }
 
             //throw a 400 error if fees to process is empty.
             fio_400_assert(fee_ids.size() > 0, "compute fees", "compute fees",
                            "No Work.", ErrorNoWork);
 
-            vector<uint64_t> votesufs;
-            int processed_fees = 0;
-
-            for(int i=0;i<fee_ids.size();i++) { //for each fee to process
-                votesufs.clear();
-                auto topprod = topprods.begin();
-                while (topprod != topprods.end()) { //get the votes of the producers, compute the voted fee, and median.
-                    //get the fee voters record of this BP.
-                    auto voters_iter = feevoters.find(topprod->producer.value);
-                    //if there is no fee voters record, then there is not a multiplier, skip this BP.
-                    if (voters_iter != feevoters.end()) {
-                        //get all the fee votes made by this BP.
-                        auto votesbybpname = feevotes.get_index<"bybpname"_n>();
-                        auto bpvote_iter = votesbybpname.find(topprod->producer.value);
-                        int countem = 0;
-
-                        if (bpvote_iter != votesbybpname.end()) {
-                            //if its in the votes list, and if it has a vote, IE end_point is greater 0, then use if.
-                            if ((bpvote_iter->feevotes.size() > fee_ids[i]) &&
-                                (bpvote_iter->feevotes[fee_ids[i]].end_point.length() > 0)) {
-                                const double dresult = voters_iter->fee_multiplier *
-                                                       (double) bpvote_iter->feevotes[fee_ids[i]].value;
-                                const uint64_t voted_fee = (uint64_t)(dresult);
-                                votesufs.push_back(voted_fee);
-                            }
-                        }
+            //load the multiplier and vote vector of each top producer once, and collect the
+            //voted fee of every pending fee in the same pass.
+            vector<vector<uint64_t>> votesufs(fee_ids.size());
+            auto votesbybpname = feevotes.get_index<"bybpname"_n>();
+            for (auto topprod = topprods.begin(); topprod != topprods.end(); topprod++) {
+                //get the fee voters record of this BP.
+                auto voters_iter = feevoters.find(topprod->producer.value);
+                //if there is no fee voters record, then there is not a multiplier, skip this BP.
+                if (voters_iter == feevoters.end()) {
+                    continue;
+                }
+                //get all the fee votes made by this BP.
+                auto bpvote_iter = votesbybpname.find(topprod->producer.value);
+                if (bpvote_iter == votesbybpname.end()) {
+                    continue;
+                }
+                const double multiplier = voters_iter->fee_multiplier;
+                const vector<feevalue_ts> &bpvotes = bpvote_iter->feevotes;
+                for (int i = 0; i < fee_ids.size(); i++) {
+                    //if its in the votes list, and if it has a vote, IE end_point is greater 0, then use if.
+                    if ((bpvotes.size() > fee_ids[i]) && (bpvotes[fee_ids[i]].end_point.length() > 0)) {
+                        const double dresult = multiplier * (double) bpvotes[fee_ids[i]].value;
+                        votesufs[i].push_back((uint64_t)(dresult));
                     }
-                    topprod++;
                 }
+            }
 
+            int processed_fees = 0;
+
+            for (int i = 0; i < fee_ids.size(); i++) { //for each fee to process
                 //compute the median from the votesufs.
+                vector<uint64_t> &feesufs = votesufs[i];
                 int64_t median_fee = -1;
-                if (votesufs.size() >= MIN_FEE_VOTERS_FOR_MEDIAN) {
-                    sort(votesufs.begin(), votesufs.end());
-                    int size = votesufs.size();
-                    if (votesufs.size() % 2 == 0) {
-                        median_fee = (votesufs[size / 2 - 1] + votesufs[size / 2]) / 2;
+                if (feesufs.size() >= MIN_FEE_VOTERS_FOR_MEDIAN) {
+                    sort(feesufs.begin(), feesufs.end());
+                    int size = feesufs.size();
+                    if (feesufs.size() % 2 == 0) {
+                        median_fee = (feesufs[size / 2 - 1] + feesufs[size / 2]) / 2;
                     } else {
-                        median_fee = votesufs[size / 2];
+                        median_fee = feesufs[size / 2];
                     }
                 }
 
@@ -130,6 +183,9 @@ namespace fioio {
                         });
                     }
                 }
+
+                //remove the fee from the work queue.
+                feependings.erase(feependings.find(fee_ids[i]));
             }
 
             fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
@@ -145,8 +201,11 @@ namespace fioio {
                 : contract(s, code, ds),
                   fiofees(_self, _self.value),
                   bundlevoters(_self, _self.value),
+                  bundleamounts(_self, _self.value),
                   feevoters(_self, _self.value),
                   feevotes(_self, _self.value),
+                  feependings(_self, _self.value),
+                  feequeuestates(_self, _self.value),
                   topprods(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
                   prods(SYSTEMACCOUNT,SYSTEMACCOUNT.value){
         }
@@ -167,10 +226,7 @@ namespace fioio {
             bool dbgout = false;
 
             //check that the actor is in the top42.
-            vector<name> top_prods = getTopProds();
-
-            fio_400_assert((std::find(top_prods.begin(), top_prods.end(), actor)) !=
-                top_prods.end(), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
+            fio_400_assert(isTopProd(actor), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
 
             fio_400_assert(max_fee >= 0, "max_fee", to_string(max_fee), "Invalid fee value",
                            ErrorMaxFeeInvalid);
@@ -230,6 +286,7 @@ namespace fioio {
                     feesbyendpoint.modify(fees_iter, _self, [&](struct fiofee &a) {
                         a.votes_pending.emplace(true);
                     });
+                    queue_pending_fee(feeid);
                 }
             }
 
@@ -249,12 +306,11 @@ namespace fioio {
             }
 
             //begin new fees, logic for Mandatory fees.
-            uint128_t endpoint_hash = string_to_uint128_hash(SUBMIT_FEE_RATIOS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(SUBMIT_FEE_RATIOS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", SUBMIT_FEE_RATIOS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", SUBMIT_FEE_RATIOS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t reg_amount = fee_iter->suf_amount;
@@ -318,9 +374,7 @@ namespace fioio {
             require_auth(actor);
 
             //check that the actor is in the top150.
-            vector<name> top_prods = getTopProds();
-            fio_400_assert((std::find(top_prods.begin(), top_prods.end(), actor)) !=
-                           top_prods.end(), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
+            fio_400_assert(isTopProd(actor), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
 
 
             fio_400_assert(bundled_transactions > 0, "bundled_transactions", to_string(bundled_transactions),
@@ -350,13 +404,14 @@ namespace fioio {
                 });
             }
 
+            update_bundle_amount();
+
             //begin new fees, logic for Mandatory fees.
-            uint128_t endpoint_hash = string_to_uint128_hash(SUBMIT_BUNDLED_TRANSACTION_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(SUBMIT_BUNDLED_TRANSACTION_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", SUBMIT_BUNDLED_TRANSACTION_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", SUBMIT_BUNDLED_TRANSACTION_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t reg_amount = fee_iter->suf_amount;
@@ -391,6 +446,18 @@ namespace fioio {
             send_response(response_string.c_str());
         }
 
+        /********
+         * This action recomputes the bundle amount from the present bundle votes of the top producers.
+         * it is sent by the system contract when the set of top producers changes.
+         */
+        // @abi action
+        [[eosio::action]]
+        void updbundleamt() {
+            eosio_assert(has_auth(SYSTEMACCOUNT) || has_auth(_self),
+                         "missing required authority of eosio or fio.fee");
+            update_bundle_amount();
+        }
+
         /**********
          * This action will create a new feevoters record if the specified block producer does not yet exist in the
          * feevoters table,
@@ -410,10 +477,7 @@ namespace fioio {
             require_auth(actor);
 
             //check that the actor is in the top42.
-            vector<name> top_prods = getTopProds();
-
-           fio_400_assert((std::find(top_prods.begin(), top_prods.end(), actor)) !=
-                           top_prods.end(), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
+            fio_400_assert(isTopProd(actor), "actor", actor.to_string()," Not a top 150 BP",ErrorFioNameNotReg);
 
             fio_400_assert(multiplier > 0, "multiplier", to_string(multiplier),
                            " Must be positive",
@@ -448,7 +512,6 @@ namespace fioio {
             //get all voted fees and set votes pending.
             auto feevotesbybpname = feevotes.get_index<"bybpname"_n>();
             auto votebyname_iter = feevotesbybpname.find(actor.value);
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
 
             if(topprods.find(actor.value) != topprods.end()) {
 
@@ -464,6 +527,7 @@ namespace fioio {
                                 fiofees.modify(fee_iter, _self, [&](struct fiofee &a) {
                                     a.votes_pending.emplace(true);
                                 });
+                                queue_pending_fee(i);
                             }
                         }
                     }
@@ -471,11 +535,11 @@ namespace fioio {
             }
 
             //begin new fees, logic for Mandatory fees.
-            uint128_t endpoint_hash = string_to_uint128_hash(SUBMIT_FEE_MULTIPLER_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(SUBMIT_FEE_MULTIPLER_ENDPOINT);
 
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             //if the fee isnt found for the endpoint, then 400 error.
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", SUBMIT_FEE_MULTIPLER_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", SUBMIT_FEE_MULTIPLER_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t reg_amount = fee_iter->suf_amount;
@@ -606,7 +670,17 @@ namespace fioio {
                            ErrorFeeInvalid);
 
             const uint128_t endPointHash = string_to_uint128_hash(end_point.c_str());
-            const uint64_t fee_id = fiofees.available_primary_key();
+            uint64_t fee_id = fiofees.available_primary_key();
+
+            //built in fees take their fixed fee_id when it is free, so they can be found without the index.
+            const fee_endpoint builtin = builtin_fee(end_point.c_str());
+            if (builtin.fee_id != NO_FIXED_FEE_ID) {
+                fio_400_assert(builtin.hash == endPointHash, "end_point", end_point,
+                               "endpoint hash mismatch", ErrorEndpointNotFound);
+                if (fiofees.find(builtin.fee_id) == fiofees.end()) {
+                    fee_id = builtin.fee_id;
+                }
+            }
 
             auto feesbyendpoint = fiofees.get_index<"byendpoint"_n>();
             auto fees_iter = feesbyendpoint.find(endPointHash);
@@ -634,6 +708,6 @@ namespace fioio {
     };
 
     EOSIO_DISPATCH(FioFee, (setfeevote)(bundlevote)(setfeemult)(computefees)
-                           (mandatoryfee)(bytemandfee)(createfee)
+                           (mandatoryfee)(bytemandfee)(createfee)(updbundleamt)
     )
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <eosiolib/eosio.hpp>
+#include <eosiolib/singleton.hpp>
 
 using std::string;
 
@@ -67,6 +68,32 @@ namespace fioio {
     >
     fiofee_table;
 
+    // this table is the work queue for computefees, it holds one row for each fee that has votes pending.
+    // rows are added whenever votes_pending is set on a fee and removed when computefees processes the fee,
+    // so computefees never has to scan the fiofees table.
+    // @abi table feepending i64
+    struct [[eosio::action]] feepending {
+        uint64_t fee_id;
+
+        uint64_t primary_key() const { return fee_id; }
+
+        EOSLIB_SERIALIZE(feepending, (fee_id)
+        )
+    };
+
+    typedef multi_index<"feepending"_n, feepending> feepending_table;
+
+    // this records whether the fees flagged votes_pending before the feepending queue existed
+    // have been loaded into the queue.
+    struct [[eosio::action]] feequeuestate {
+        bool seeded = false;
+
+        EOSLIB_SERIALIZE(feequeuestate, (seeded)
+        )
+    };
+
+    typedef singleton<"feequeuest"_n, feequeuestate> feequeuestate_singleton;
+
 
     // this is the feevoter table, it holds the votes made for fees, a fee vote has producer name and
     // a multiplier that will be applied to the vote to arrive at the final fee amount used.
@@ -100,6 +127,19 @@ namespace fioio {
 
     typedef multi_index<"bundlevoters"_n, bundlevoter> bundlevoters_table;
 
+    // the bundleamount singleton holds the present median of the bundle votes of the top producers.
+    // it is recomputed by bundlevote and when the producer schedule changes, registrations read it
+    // rather than computing the median.
+    struct [[eosio::action]] bundleamount {
+        uint64_t bundled_transactions = 0;
+        uint64_t lastupdatetimestamp = 0;
+
+        EOSLIB_SERIALIZE(bundleamount, (bundled_transactions)(lastupdatetimestamp)
+        )
+    };
+
+    typedef singleton<"bundleamount"_n, bundleamount> bundleamount_singleton;
+
 
     //this structure is retired, left here so that replays can be achieved.
     struct [[eosio::action]] feevote {
@@ -19,10 +19,10 @@ namespace fioio {
     class [[eosio::contract("FIOOracle")]]  FIOOracle : public eosio::contract {
 
     private:
+        power_update_sender power_updates;
         oracleledger_table receipts;
         oraclevoters_table voters;
         oracles_table oracles;
-        fionames_table fionames;
         domains_table domains;
         eosiosystem::producers_table producers;
         eosio_names_table accountmap;
@@ -39,8 +39,7 @@ namespace fioio {
                 oracles(_self, _self.value),
                 producers(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
                 accountmap(AddressContract, AddressContract.value),
-                fiofees(FeeContract, FeeContract.value),
-                fionames(AddressContract, AddressContract.value) {
+                fiofees(FeeContract, FeeContract.value) {
             configs_singleton configsSingleton(FeeContract, FeeContract.value);
             appConfig = configsSingleton.get_or_default(config());
         }
@@ -112,10 +111,7 @@ namespace fioio {
                 ).send();
 
                 //update voting power for receiver
-                action(permission_level{SYSTEMACCOUNT, "active"_n},
-                       SYSTEMACCOUNT, "updatepower"_n,
-                       make_tuple(name{idx->actor}, true)
-                ).send();
+                queue_power_update(name{idx->actor}, true, SYSTEMACCOUNT);
 
                 idx++;
             }
@@ -137,14 +133,13 @@ namespace fioio {
             ).send();
 
             //Chain wrap_fio_token fee is collected.
-            const uint128_t endpoint_hash = string_to_uint128_hash(WRAP_FIO_TOKENS_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(WRAP_FIO_TOKENS_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             const uint64_t fee_type = fee_iter->type;
             const int64_t wrap_amount = fee_iter->suf_amount;
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", WRAP_FIO_TOKENS_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", WRAP_FIO_TOKENS_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t fee_amount = fee_iter->suf_amount;
@@ -196,16 +191,14 @@ namespace fioio {
             fio_400_assert(oraclesearch != oracles.end(), "actor", actor.to_string(),
                            "Not a registered Oracle", ErrorPubAddressExist);
 
-            const uint128_t nameHash = string_to_uint128_hash(fio_address);
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
+            const resolved_address &address = resolve_fio_address(fio_address);
 
             const uint128_t idHash = string_to_uint128_hash(obt_id);
             auto votesbyid = voters.get_index<"byidhash"_n>();
             auto voters_iter = votesbyid.find(idHash);
 
-            fio_404_assert(fioname_iter != namesbyname.end(), "FIO Address not found", ErrorFioNameNotRegistered);
-            const uint64_t recAcct = fioname_iter->owner_account;
+            fio_404_assert(address.found, "FIO Address not found", ErrorFioNameNotRegistered);
+            const uint64_t recAcct = address.owner;
 
             vector<name> tempvoters;
 
@@ -438,10 +431,7 @@ namespace fioio {
                        make_tuple(actor, name{idx->actor}, asset(feeFinal, FIOSYMBOL), string("Token Wrapping Oracle Fee"))
                 ).send();
 
-                action(permission_level{SYSTEMACCOUNT, "active"_n},
-                       SYSTEMACCOUNT, "updatepower"_n,
-                       make_tuple(name{idx->actor}, true)
-                ).send();
+                queue_power_update(name{idx->actor}, true, SYSTEMACCOUNT);
 
                 idx++;
             }
@@ -468,14 +458,13 @@ namespace fioio {
             ).send();
 
             //Chain wrap_fio_token fee is collected.
-            const uint128_t endpoint_hash = string_to_uint128_hash(WRAP_FIO_DOMAIN_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(WRAP_FIO_DOMAIN_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
             const uint64_t fee_type = fee_iter->type;
             const int64_t wrap_amount = fee_iter->suf_amount;
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", WRAP_FIO_DOMAIN_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", WRAP_FIO_DOMAIN_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t fee_amount = fee_iter->suf_amount;
@@ -535,16 +524,14 @@ namespace fioio {
             fio_400_assert(oraclesearch != oracles.end(), "actor", actor.to_string(),
                            "Not a registered Oracle", ErrorPubAddressExist);
 
-            const uint128_t nameHash = string_to_uint128_hash(fio_address);
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
+            const resolved_address &address = resolve_fio_address(fio_address);
 
             const uint128_t idHash = string_to_uint128_hash(obt_id);
             auto votesbyid = voters.get_index<"byidhash"_n>();
             auto voters_iter = votesbyid.find(idHash);
 
-            fio_404_assert(fioname_iter != namesbyname.end(), "FIO Address not found", ErrorFioNameNotRegistered);
-            const uint64_t recAcct = fioname_iter->owner_account;
+            fio_404_assert(address.found, "FIO Address not found", ErrorFioNameNotRegistered);
+            const uint64_t recAcct = address.owner;
 
             vector<name> tempvoters;
 
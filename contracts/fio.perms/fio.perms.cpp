@@ -51,6 +51,7 @@ namespace fioio {
 
     private:
 
+        power_update_sender power_updates;
         domains_table     domains;
         fionames_table    fionames;
         fiofee_table      fiofees;
@@ -231,10 +232,9 @@ namespace fioio {
 
 
             //fees
-            const uint128_t endpoint_hash = string_to_uint128_hash(ADD_PERMISSION_ENDPOINT);
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", ADD_PERMISSION_ENDPOINT,
+            constexpr fee_endpoint endpoint_fee = builtin_fee(ADD_PERMISSION_ENDPOINT);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", ADD_PERMISSION_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
             const uint64_t fee_amount = fee_iter->suf_amount;
             const uint64_t fee_type = fee_iter->type;
@@ -252,10 +252,7 @@ namespace fioio {
 
 
             if (fee_amount > 0) {
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        (SYSTEMACCOUNT, {{_self, "active"_n}},
-                         {actor, true}
-                        );
+                queue_power_update(actor, true, _self);
             }
 
 
@@ -381,11 +378,10 @@ namespace fioio {
                            ErrorPubKeyValid);
 
             //fees
-            const uint128_t endpoint_hash    = string_to_uint128_hash(REMOVE_PERMISSION_ENDPOINT);
-            auto            fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto            fee_iter         = fees_by_endpoint.find(endpoint_hash);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REMOVE_PERMISSION_ENDPOINT);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REMOVE_PERMISSION_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REMOVE_PERMISSION_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t fee_amount = fee_iter->suf_amount;
@@ -403,10 +399,7 @@ namespace fioio {
             processbucketrewards(tpid, fee_amount, get_self(), actor);
 
             if (fee_amount > 0) {
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        (SYSTEMACCOUNT, {{_self, "active"_n}},
-                         {actor, true}
-                        );
+                queue_power_update(actor, true, _self);
             }
             const string response_string = "{\"status\": \"OK\", \"fee_collected\" : "+ to_string(fee_amount) +"}";
             send_response(response_string.c_str());
@@ -21,14 +21,13 @@ namespace fioio {
     class [[eosio::contract("FioRequestObt")]]  FioRequestObt : public eosio::contract {
 
     private:
+        power_update_sender power_updates;
         fiotrxts_contexts_table fioTransactionsTable; //Migration Table
         migrledgers_table mgrStatsTable; // Migration Ledger (temp)
         fiorequest_contexts_table fiorequestContextsTable;
         fiorequest_status_table fiorequestStatusTable;
         fionames_table fionames;
-        fionameinfo_table fionameinfo;
         domains_table domains;
-        eosio_names_table clientkeys;
         fiofee_table fiofees;
         config appConfig;
         tpids_table tpids;
@@ -43,10 +42,8 @@ namespace fioio {
                   fiorequestContextsTable(_self, _self.value),
                   fiorequestStatusTable(_self, _self.value),
                   fionames(AddressContract, AddressContract.value),
-                  fionameinfo(AddressContract,AddressContract.value),
                   domains(AddressContract, AddressContract.value),
                   fiofees(FeeContract, FeeContract.value),
-                  clientkeys(AddressContract, AddressContract.value),
                   tpids(AddressContract, AddressContract.value),
                   producers(SYSTEMACCOUNT, SYSTEMACCOUNT.value), //Temp
                   mgrStatsTable(_self, _self.value), // Temp
@@ -56,34 +53,100 @@ namespace fioio {
         }
 
 
-        inline string get_encrypt_key(const uint64_t fionameid,const uint64_t acct) {
-            auto fionameinfobynameid = fionameinfo.get_index<"byfionameid"_n>();
-            auto fionameinfo_iter = fionameinfobynameid.find(fionameid);
-            if(fionameinfo_iter == fionameinfobynameid.end()){
-                auto account_iter = clientkeys.find(acct);
-                fio_400_assert(account_iter != clientkeys.end(), "acct", to_string(acct),
-                               "No client key found for account in account map",
-                               ErrorClientKeyNotFound);
-                return account_iter->clientkey;
-
-            }else {
-                //now check for multiples. no duplicates permitted in table.
-                int countem = 0;
-                string retval = "";
-                while (fionameinfo_iter != fionameinfobynameid.end()) {
-                    if ( (fionameinfo_iter->datadesc.compare(FIO_REQUEST_CONTENT_ENCRYPTION_PUB_KEY_DATA_DESC) == 0) && (fionameinfo_iter->fionameid == fionameid)) {
-                        retval = fionameinfo_iter->datavalue;
-                        countem++;
-                    }else if (fionameinfo_iter->fionameid != fionameid){
-                        break;
-                    }
-                    fionameinfo_iter++;
+        //the id counter of fiotrxtss, seeded from the table the first time it is used.
+        inline trxidstate trx_id_state(trxidstate_singleton &idSingleton) {
+            if (idSingleton.exists()) {
+                return idSingleton.get();
+            }
+            trxidstate state;
+            state.next_id = fioTransactionsTable.available_primary_key();
+            return state;
+        }
+
+        inline uint64_t next_trx_id() {
+            trxidstate_singleton idSingleton(_self, _self.value);
+            trxidstate state = trx_id_state(idSingleton);
+            const uint64_t id = state.next_id;
+            state.next_id = id + 1;
+            idSingleton.set(state, _self);
+            return id;
+        }
+
+        //reduce a row to a stub, the content is replaced by its hash.
+        inline void stub_trx(fiotrxt_info &t) {
+            const string content = t.req_content + t.obt_content;
+            t.content_hash.emplace(eosio::sha256(content.c_str(), content.size()));
+            t.req_content = "";
+            t.obt_content = "";
+        }
+
+        //resolve an address used by a batch action with its encryption key, an address repeated in the batch
+        //is resolved once.
+        inline const resolved_address &resolve_party(const string &fio_address, const char *field) {
+            const resolved_address &ra = resolve_fio_address(fio_address);
+            fio_400_assert(ra.found, field, fio_address,
+                           "No such FIO Address", ErrorFioNameNotReg);
+            resolve_encrypt_key(fio_address);
+            return ra;
+        }
+
+        //charge a batch once, either the bundles of all items from the signing address or the fee of all items.
+        //multiplier is the sum of the content multipliers of the items. returns the fee collected.
+        inline uint64_t charge_batch(const resolved_address &signer, const string &endpoint,
+                                     const fee_endpoint &endpoint_fee, const uint64_t multiplier,
+                                     const int64_t &max_fee, const name &actor, const string &tpid) {
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
+
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", endpoint,
+                           "FIO fee not found for endpoint", ErrorNoEndpoint);
+
+            const uint64_t fee_type = fee_iter->type;
+            fio_400_assert(fee_type == 1, "fee_type", to_string(fee_type),
+                           "unexpected fee type for endpoint " + endpoint + ", expected 1", ErrorNoEndpoint);
+
+            const uint64_t bundleAmount = 2 * multiplier;
+            uint64_t fee_amount = 0;
+
+            if (signer.bundleeligiblecountdown >= bundleAmount) {
+                charge_bundle(_self, signer.fionameid, bundleAmount);
+            } else {
+                fee_amount = fee_iter->suf_amount * multiplier;
+                fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
+                               "Fee exceeds supplied maximum.",
+                               ErrorMaxFeeExceeded);
+
+                fio_fees(actor, asset(fee_amount, FIOSYMBOL), endpoint);
+                process_rewards(tpid, fee_amount, get_self(), actor);
+
+                if (fee_amount > 0) {
+                    queue_power_update(actor, true, _self);
                 }
-                fio_400_assert(countem == 1, "datadesc", FIO_REQUEST_CONTENT_ENCRYPTION_PUB_KEY_DATA_DESC,
-                               "handle info error -- multiple data values present for datadesc ",
-                               ErrorInvalidValue);
-                return retval;
             }
+            //handle auto proxy
+            if (!tpid.empty()) {
+                set_auto_proxy(tpid, 0, get_self(), actor);
+            }
+            return fee_amount;
+        }
+
+        //the content multiplier used for fees and RAM, one per started BASECONTENTAMOUNT bytes.
+        inline uint64_t content_multiplier(const string &content) {
+            return content.size() >= BASECONTENTAMOUNT ? (content.size() / BASECONTENTAMOUNT) + 1 : 1;
+        }
+
+        //the RAM granted for one item with the specified content multiplier.
+        inline uint64_t content_ram(const uint64_t baseram, const uint64_t multiplier) {
+            return multiplier > 1 ? baseram + ((baseram * multiplier) / 2) : baseram;
+        }
+
+        //find the request with the specified id, the end of fioTransactionsTable when there is none.
+        inline fiotrxts_contexts_table::const_iterator find_request(const uint64_t requestId) {
+            auto trxtByRequestId = fioTransactionsTable.get_index<"byrequestid"_n>();
+            auto trx_iter = trxtByRequestId.find(requestId);
+            if (trx_iter == trxtByRequestId.end()) {
+                return fioTransactionsTable.end();
+            }
+            return fioTransactionsTable.iterator_to(*trx_iter);
         }
 
         //TEMP MIGRATION ACTION
@@ -140,6 +203,97 @@ namespace fioio {
         // END OF TEMP MIGRATION ACTION
 
 
+        /*******
+         * This action sets the retention policy for fiotrxtss rows in a terminal state.
+         * @param max_age  rows whose obt_time is this many seconds ago or earlier may be pruned, 0 keeps all rows.
+         * @param keep_stub  when set pruned rows are kept as stubs holding the hash of their content.
+         */
+        // @abi action
+        [[eosio::action]]
+        void setretention(const uint32_t &max_age, const bool &keep_stub) {
+            eosio_assert(has_auth(SYSTEMACCOUNT), "missing required authority of eosio");
+
+            trxretention_singleton retentionSingleton(_self, _self.value);
+            trxretention retention = retentionSingleton.get_or_default();
+            retention.max_age = max_age;
+            retention.keep_stub = keep_stub;
+            //start over, rows passed under the previous policy may qualify under this one.
+            retention.next_time = 0;
+            retention.next_id = 0;
+            retentionSingleton.set(retention, _self);
+        }
+
+        /*******
+         * This action prunes up to amount (at most 25) fiotrxtss rows in a terminal state that are older than the
+         * retention policy allows, it can be called by any account until it reports no work.
+         * @param amount  the number of rows to visit.
+         * @param actor  the account signing this transaction.
+         */
+        // @abi action
+        [[eosio::action]]
+        void prunetrx(const uint16_t amount, const string &actor) {
+            const name aactor = name(actor.c_str());
+            require_auth(aactor);
+
+            trxretention_singleton retentionSingleton(_self, _self.value);
+            trxretention retention = retentionSingleton.get_or_default();
+            fio_400_assert(retention.max_age > 0, "prunetrx", "prunetrx", "No Work.", ErrorNoWork);
+
+            //seed the id counter before any row is removed, so ids freed here are never handed out again.
+            trxidstate_singleton idSingleton(_self, _self.value);
+            if (!idSingleton.exists()) {
+                idSingleton.set(trx_id_state(idSingleton), _self);
+            }
+
+            const uint64_t present_time = now();
+            const uint64_t cutoff = present_time > retention.max_age ? present_time - retention.max_age : 0;
+
+            //stubs are left in place, so the rows visited are bounded separately from the rows pruned.
+            //the cursor is saved after every visit, so stubs are never visited twice. rows sharing the
+            //obt_time of the cursor are ordered by id, those below the cursor id were visited before.
+            const uint16_t limit = amount > 25 ? 25 : amount;
+            const uint16_t maxvisits = limit * 4;
+            uint16_t visits = 0;
+            uint64_t pruned = 0;
+            auto byobttime = fioTransactionsTable.get_index<"byobttime"_n>();
+            //pending requests have no obt_time and sort before every terminal row.
+            auto trx_iter = byobttime.lower_bound(retention.next_time > 0 ? retention.next_time : 1);
+            while (trx_iter != byobttime.end() && trx_iter->obt_time < cutoff && pruned < limit &&
+                   visits < maxvisits) {
+                if (trx_iter->obt_time == retention.next_time && trx_iter->id < retention.next_id) {
+                    trx_iter++;
+                    continue;
+                }
+                retention.next_time = trx_iter->obt_time;
+                retention.next_id = trx_iter->id + 1;
+                visits++;
+                if (!retention.keep_stub) {
+                    trx_iter = byobttime.erase(trx_iter);
+                    pruned++;
+                } else {
+                    if (!trx_iter->content_hash.has_value()) {
+                        byobttime.modify(trx_iter, _self, [&](struct fiotrxt_info &t) {
+                            stub_trx(t);
+                        });
+                        pruned++;
+                    }
+                    trx_iter++;
+                }
+            }
+            fio_400_assert(visits > 0, "prunetrx", "prunetrx", "No Work.", ErrorNoWork);
+
+            retention.pruned += pruned;
+            retentionSingleton.set(retention, _self);
+
+            const string response_string = string("{\"status\": \"OK\",\"pruned\":") + to_string(pruned) +
+                                           string(",\"visited\":") + to_string(visits) + string("}");
+
+            fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
+                           "Transaction is too large", ErrorTransactionTooLarge);
+
+            send_response(response_string.c_str());
+        }
+
          /*******
           * This action will record the send of funds from one FIO address to another, either
           * in response to a request for funds or as a result of a direct send of funds from
@@ -180,55 +334,43 @@ namespace fioio {
             fio_400_assert(content.size() >= 64, "content", content,
                            "Requires min 64", ErrorContentLimit);
 
-            FioAddress payerfa;
-            getFioAddressStruct(payer_fio_address, payerfa);
-
             uint32_t present_time = now();
 
-            uint128_t nameHash = string_to_uint128_hash(payer_fio_address.c_str());
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
-            fio_400_assert(fioname_iter != namesbyname.end(), "payer_fio_address", payer_fio_address,
+            const resolved_address &payer = resolve_fio_address(payer_fio_address);
+            fio_400_assert(payer.found, "payer_fio_address", payer_fio_address,
                            "No such FIO Address",
                            ErrorFioNameNotReg);
-            uint64_t payer_acct = fioname_iter->owner_account;
-            uint128_t domHash = string_to_uint128_hash(payerfa.fiodomain.c_str());
+            uint64_t payer_acct = payer.owner;
 
-            auto domainsbyname = domains.get_index<"byname"_n>();
-            auto iterdom = domainsbyname.find(domHash);
-
-            fio_400_assert(iterdom != domainsbyname.end(), "payer_fio_address", payer_fio_address,
+            fio_400_assert(payer.domain_found, "payer_fio_address", payer_fio_address,
                            "No such domain",
                            ErrorDomainNotRegistered);
-            uint32_t domexp = iterdom->expiration;
+            uint32_t domexp = payer.domain_expiration;
             //add 30 days to the domain expiration, this call will work until 30 days past expire.
             domexp = get_time_plus_seconds(domexp, SECONDS30DAYS);
 
             fio_400_assert(present_time <= domexp, "payer_fio_address", payer_fio_address,
                            "FIO Domain expired", ErrorDomainExpired);
 
-            string payer_key = get_encrypt_key(fioname_iter->id,payer_acct);
+            string payer_key = resolve_encrypt_key(payer_fio_address);
 
-            nameHash = string_to_uint128_hash(payee_fio_address.c_str());
-            namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter2 = namesbyname.find(nameHash);
+            const resolved_address &payee = resolve_fio_address(payee_fio_address);
 
-            fio_400_assert(fioname_iter2 != namesbyname.end(), "payee_fio_address", payee_fio_address,
+            fio_400_assert(payee.found, "payee_fio_address", payee_fio_address,
                            "No such FIO Address",
                            ErrorFioNameNotReg);
 
             fio_403_assert(payer_acct == aactor.value, ErrorSignature);
 
-            uint64_t payee_acct = fioname_iter2->owner_account;
-            string payee_key = get_encrypt_key(fioname_iter2->id,payee_acct);
+            uint64_t payee_acct = payee.owner;
+            string payee_key = resolve_encrypt_key(payee_fio_address);
 
             //begin fees, bundle eligible fee logic
-            uint128_t endpoint_hash = string_to_uint128_hash(RECORD_OBT_DATA_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(RECORD_OBT_DATA_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", RECORD_OBT_DATA_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", RECORD_OBT_DATA_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             uint64_t fee_type = fee_iter->type;
@@ -240,13 +382,8 @@ namespace fioio {
             uint64_t bundleAmount = 2 * feeMultiplier;
             uint64_t fee_amount = 0;
 
-            if (fioname_iter->bundleeligiblecountdown >= bundleAmount) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(payer_fio_address, bundleAmount)
-                }.send();
+            if (payer.bundleeligiblecountdown >= bundleAmount) {
+                charge_bundle(_self, payer.fionameid, bundleAmount);
             } else {
                 fee_amount = fee_iter->suf_amount * feeMultiplier;
                 fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -257,10 +394,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), aactor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {aactor, true}
-                            );
+                    queue_power_update(aactor, true, _self);
                 }
             }
             //handle auto proxy
@@ -272,10 +406,9 @@ namespace fioio {
                 uint64_t requestId;
                 requestId = std::atoi(fio_request_id.c_str());
 
-                auto trxtByRequestId = fioTransactionsTable.get_index<"byrequestid"_n>();
-                auto fioreqctx_iter = trxtByRequestId.find(requestId);
+                auto fioreqctx_iter = find_request(requestId);
 
-                fio_400_assert(fioreqctx_iter != trxtByRequestId.end(), "fio_request_id", fio_request_id,
+                fio_400_assert(fioreqctx_iter != fioTransactionsTable.end(), "fio_request_id", fio_request_id,
                                "No such FIO Request", ErrorRequestContextNotFound);
 
                 //make sure payer of the request matches the actor.
@@ -284,20 +417,18 @@ namespace fioio {
                 fio_400_assert(fioreqctx_iter->fio_data_type == 0, "fio_request_id", fio_request_id,
                                "Only pending requests can be responded.", ErrorRequestStatusInvalid);
 
-                trxtByRequestId.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
+                fioTransactionsTable.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
                     fr.fio_data_type = static_cast<int64_t>(trxstatus::sent_to_blockchain);
                     fr.obt_content = content;
                     fr.obt_time = present_time;
                 });
             } else {
-                const uint64_t id = fioTransactionsTable.available_primary_key();
-                const uint128_t toHash = string_to_uint128_hash(payee_fio_address.c_str());
-                const uint128_t fromHash = string_to_uint128_hash(payer_fio_address.c_str());
+                const uint64_t id = next_trx_id();
 
                 fioTransactionsTable.emplace(aactor, [&](struct fiotrxt_info &obtinf) {
                     obtinf.id = id;
-                    obtinf.payer_fio_addr_hex = fromHash;
-                    obtinf.payee_fio_addr_hex = toHash;
+                    obtinf.payer_fio_addr_hex = payer.namehash;
+                    obtinf.payee_fio_addr_hex = payee.namehash;
                     obtinf.obt_content = content;
                     obtinf.fio_data_type = static_cast<int64_t>(trxstatus::obt_action);
                     obtinf.obt_time = present_time;
@@ -372,52 +503,38 @@ namespace fioio {
 
             const uint32_t present_time = now();
 
-            FioAddress payerfa, payeefa;
-            getFioAddressStruct(payer_fio_address, payerfa);
-            getFioAddressStruct(payee_fio_address, payeefa);
-
-            uint128_t nameHash = string_to_uint128_hash(payer_fio_address.c_str());
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter2 = namesbyname.find(nameHash);
-            fio_400_assert(fioname_iter2 != namesbyname.end(), "payer_fio_address", payer_fio_address,
+            const resolved_address &payer = resolve_fio_address(payer_fio_address);
+            fio_400_assert(payer.found, "payer_fio_address", payer_fio_address,
                            "No such FIO Address",
                            ErrorFioNameNotReg);
 
-            uint64_t payer_acct = fioname_iter2->owner_account;
-            string payer_key = get_encrypt_key(fioname_iter2->id, payer_acct);
-
+            uint64_t payer_acct = payer.owner;
+            string payer_key = resolve_encrypt_key(payer_fio_address);
 
-            nameHash = string_to_uint128_hash(payee_fio_address.c_str());
-            namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
-            fio_400_assert(fioname_iter != namesbyname.end(), "payee_fio_address", payee_fio_address,
+            const resolved_address &payee = resolve_fio_address(payee_fio_address);
+            fio_400_assert(payee.found, "payee_fio_address", payee_fio_address,
                            "No such FIO Address",
                            ErrorFioNameNotReg);
 
-            uint64_t payee_acct = fioname_iter->owner_account;
-            string payee_key = get_encrypt_key( fioname_iter->id, payee_acct);
-
-            const uint128_t domHash = string_to_uint128_hash(payeefa.fiodomain.c_str());
-            auto domainsbyname = domains.get_index<"byname"_n>();
-            auto iterdom = domainsbyname.find(domHash);
+            uint64_t payee_acct = payee.owner;
+            string payee_key = resolve_encrypt_key(payee_fio_address);
 
-            fio_400_assert(iterdom != domainsbyname.end(), "payee_fio_address", payee_fio_address,
+            fio_400_assert(payee.domain_found, "payee_fio_address", payee_fio_address,
                            "No such domain",
                            ErrorDomainNotRegistered);
 
             //add 30 days to the domain expiration, this call will work until 30 days past expire.
-            const uint64_t domexp = get_time_plus_seconds(iterdom->expiration, SECONDS30DAYS);
+            const uint64_t domexp = get_time_plus_seconds(payee.domain_expiration, SECONDS30DAYS);
             fio_400_assert(present_time <= domexp, "payee_fio_address", payee_fio_address,
                            "FIO Domain expired", ErrorDomainExpired);
 
             fio_403_assert(payee_acct == aActor.value, ErrorSignature);
 
             //begin fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(NEW_FUNDS_REQUEST_ENDPOINT);
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(NEW_FUNDS_REQUEST_ENDPOINT);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", NEW_FUNDS_REQUEST_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", NEW_FUNDS_REQUEST_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t fee_type = fee_iter->type;
@@ -430,13 +547,8 @@ namespace fioio {
             uint64_t bundleAmount = 2 * feeMultiplier;
             uint64_t fee_amount = 0;
 
-            if (fioname_iter->bundleeligiblecountdown >= bundleAmount) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(payee_fio_address, bundleAmount)
-                }.send();
+            if (payee.bundleeligiblecountdown >= bundleAmount) {
+                charge_bundle(_self, payee.fionameid, bundleAmount);
             } else {
                 fee_amount = fee_iter->suf_amount * feeMultiplier;
                 fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -447,10 +559,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), aActor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {aActor, true}
-                            );
+                    queue_power_update(aActor, true, _self);
                 }
             }
 
@@ -459,15 +568,13 @@ namespace fioio {
                 set_auto_proxy(tpid, 0, get_self(), aActor);
             }
             //end fees, bundle eligible fee logic
-            const uint64_t id = fioTransactionsTable.available_primary_key();
-            const uint128_t toHash = string_to_uint128_hash(payee_fio_address.c_str());
-            const uint128_t fromHash = string_to_uint128_hash(payer_fio_address.c_str());
+            const uint64_t id = next_trx_id();
 
             fioTransactionsTable.emplace(aActor, [&](struct fiotrxt_info &frc) {
                 frc.id = id;
                 frc.fio_request_id = id;
-                frc.payer_fio_addr_hex = fromHash;
-                frc.payee_fio_addr_hex = toHash;
+                frc.payer_fio_addr_hex = payer.namehash;
+                frc.payee_fio_addr_hex = payee.namehash;
                 frc.req_content = content;
                 frc.fio_data_type = static_cast<int64_t>(trxstatus::requested);
                 frc.req_time = present_time;
@@ -501,6 +608,242 @@ namespace fioio {
             send_response(response_string.c_str());
         }
 
+       /*********
+        * This action records several requests for funds from one payee in one action. the payee address is
+        * resolved once, bundles or fees are charged once for the whole batch and the results of the
+        * requests are returned together.
+        * @param payee_fio_address this is the requestor of the funds (or the payee) for all the requests.
+        * @param requests  the payer fio address and the encrypted content of each request, at most MAX_BATCH_ITEMS.
+        * @param max_fee  this is the maximum fee that the sender of this transaction is willing to pay for the batch.
+        * @param actor this is the string representation of the fio account that has signed this transaction
+        * @param tpid
+        */
+        // @abi action
+        [[eosio::action]]
+        void batchfndreq(
+                const string &payee_fio_address,
+                const std::vector<fundsreq_item> &requests,
+                const int64_t &max_fee,
+                const string &actor,
+                const string &tpid) {
+
+            const name aActor = name(actor.c_str());
+            require_auth(aActor);
+            fio_400_assert(validateTPIDFormat(tpid), "tpid", tpid,
+                           "TPID must be empty or valid FIO address",
+                           ErrorPubKeyValid);
+            fio_400_assert(max_fee >= 0, "max_fee", to_string(max_fee), "Invalid fee value",
+                           ErrorMaxFeeInvalid);
+            fio_400_assert(requests.size() > 0 && requests.size() <= MAX_BATCH_ITEMS, "requests",
+                           to_string(requests.size()), "Invalid number of requests", ErrorInvalidValue);
+            fio_400_assert(payee_fio_address.length() > 0, "payee_fio_address", payee_fio_address,
+                           "to fio address not specified",
+                           ErrorInvalidJsonInput);
+
+            const uint32_t present_time = now();
+
+            const resolved_address &payee = resolve_party(payee_fio_address, "payee_fio_address");
+
+            fio_400_assert(payee.domain_found, "payee_fio_address", payee_fio_address,
+                           "No such domain",
+                           ErrorDomainNotRegistered);
+
+            //add 30 days to the domain expiration, this call will work until 30 days past expire.
+            const uint64_t domexp = get_time_plus_seconds(payee.domain_expiration, SECONDS30DAYS);
+            fio_400_assert(present_time <= domexp, "payee_fio_address", payee_fio_address,
+                           "FIO Domain expired", ErrorDomainExpired);
+
+            fio_403_assert(payee.owner == aActor.value, ErrorSignature);
+
+            uint64_t multiplier = 0;
+            uint64_t ramAmount = 0;
+            for (const auto &request : requests) {
+                fio_400_assert(request.payer_fio_address.length() > 0, "payer_fio_address", request.payer_fio_address,
+                               "from fio address not specified",
+                               ErrorInvalidJsonInput);
+                fio_400_assert(request.content.size() >= 64, "content", request.content,
+                               "Requires min 64",
+                               ErrorContentLimit);
+                const uint64_t itemMultiplier = content_multiplier(request.content);
+                multiplier += itemMultiplier;
+                ramAmount += content_ram(NEWFUNDSREQUESTRAM, itemMultiplier);
+            }
+
+            constexpr fee_endpoint endpoint_fee = builtin_fee(NEW_FUNDS_REQUEST_ENDPOINT);
+            const uint64_t fee_amount = charge_batch(payee, NEW_FUNDS_REQUEST_ENDPOINT, endpoint_fee, multiplier,
+                                                     max_fee, aActor, tpid);
+
+            string results = "";
+            for (const auto &request : requests) {
+                const resolved_address &payer = resolve_party(request.payer_fio_address, "payer_fio_address");
+                const uint64_t id = next_trx_id();
+
+                fioTransactionsTable.emplace(aActor, [&](struct fiotrxt_info &frc) {
+                    frc.id = id;
+                    frc.fio_request_id = id;
+                    frc.payer_fio_addr_hex = payer.namehash;
+                    frc.payee_fio_addr_hex = payee.namehash;
+                    frc.req_content = request.content;
+                    frc.fio_data_type = static_cast<int64_t>(trxstatus::requested);
+                    frc.req_time = present_time;
+                    frc.payer_fio_addr = request.payer_fio_address;
+                    frc.payee_fio_addr = payee_fio_address;
+                    frc.payee_key = payee.encrypt_key;
+                    frc.payer_key = payer.encrypt_key;
+                    frc.payee_account = payee.owner;
+                    frc.payer_account = payer.owner;
+                });
+
+                if (!results.empty()) { results += ","; }
+                results += string("{\"fio_request_id\":") + to_string(id) + string(",\"status\":\"requested\"}");
+            }
+
+            const string response_string = string("{\"results\":[") + results + string("]") +
+                                           string(",\"fee_collected\":") + to_string(fee_amount) + string("}");
+
+            if (NEWFUNDSREQUESTRAM > 0) {
+                action(
+                        permission_level{SYSTEMACCOUNT, "active"_n},
+                        "eosio"_n,
+                        "incram"_n,
+                        std::make_tuple(aActor, ramAmount)
+                ).send();
+            }
+            fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
+                           "Transaction is too large", ErrorTransactionTooLarge);
+
+            send_response(response_string.c_str());
+        }
+
+         /*******
+          * This action records several obt records from one payer in one action. the payer address and domain
+          * are resolved once, bundles or fees are charged once for the whole batch and the results of the
+          * records are returned together.
+          * @param payer_fio_address The payer of all the records.
+          * @param records  the request id (may be empty), the payee fio address and the encrypted content of
+          *                 each record, at most MAX_BATCH_ITEMS.
+          * @param max_fee  this is maximum fee the user is willing to pay for the batch.
+          * @param actor  this is the actor (the account which has signed this transaction)
+          * @param tpid  this is the tpid for the owner of the domain (this is optional)
+          */
+        // @abi action
+        [[eosio::action]]
+        void batchrecobt(
+                const string &payer_fio_address,
+                const std::vector<obt_item> &records,
+                const int64_t &max_fee,
+                const string &actor,
+                const string &tpid) {
+
+            name aactor = name(actor.c_str());
+            require_auth(aactor);
+            fio_400_assert(validateTPIDFormat(tpid), "tpid", tpid,
+                           "TPID must be empty or valid FIO address",
+                           ErrorPubKeyValid);
+            fio_400_assert(max_fee >= 0, "max_fee", to_string(max_fee), "Invalid fee value",
+                           ErrorMaxFeeInvalid);
+            fio_400_assert(records.size() > 0 && records.size() <= MAX_BATCH_ITEMS, "records",
+                           to_string(records.size()), "Invalid number of records", ErrorInvalidValue);
+            fio_400_assert(payer_fio_address.length() > 0, "payer_fio_address", payer_fio_address,
+                           "from fio address not found", ErrorInvalidFioNameFormat);
+
+            const uint32_t present_time = now();
+
+            const resolved_address &payer = resolve_party(payer_fio_address, "payer_fio_address");
+
+            fio_400_assert(payer.domain_found, "payer_fio_address", payer_fio_address,
+                           "No such domain",
+                           ErrorDomainNotRegistered);
+            //add 30 days to the domain expiration, this call will work until 30 days past expire.
+            const uint32_t domexp = get_time_plus_seconds(payer.domain_expiration, SECONDS30DAYS);
+
+            fio_400_assert(present_time <= domexp, "payer_fio_address", payer_fio_address,
+                           "FIO Domain expired", ErrorDomainExpired);
+
+            fio_403_assert(payer.owner == aactor.value, ErrorSignature);
+
+            uint64_t multiplier = 0;
+            uint64_t ramAmount = 0;
+            for (const auto &record : records) {
+                fio_400_assert(record.fio_request_id.length() < 16, "fio_request_id", record.fio_request_id,
+                               "No such FIO Request", ErrorRequestContextNotFound);
+                fio_400_assert(record.payee_fio_address.length() > 0, "payee_fio_address", record.payee_fio_address,
+                               "to fio address not found", ErrorInvalidFioNameFormat);
+                fio_400_assert(record.content.size() >= 64, "content", record.content,
+                               "Requires min 64", ErrorContentLimit);
+                const uint64_t itemMultiplier = content_multiplier(record.content);
+                multiplier += itemMultiplier;
+                ramAmount += content_ram(RECORDOBTRAM, itemMultiplier);
+            }
+
+            constexpr fee_endpoint endpoint_fee = builtin_fee(RECORD_OBT_DATA_ENDPOINT);
+            const uint64_t fee_amount = charge_batch(payer, RECORD_OBT_DATA_ENDPOINT, endpoint_fee, multiplier,
+                                                     max_fee, aactor, tpid);
+
+            string results = "";
+            for (const auto &record : records) {
+                const resolved_address &payee = resolve_party(record.payee_fio_address, "payee_fio_address");
+
+                if (record.fio_request_id.length() > 0) {
+                    const uint64_t requestId = std::atoi(record.fio_request_id.c_str());
+
+                    auto fioreqctx_iter = find_request(requestId);
+
+                    fio_400_assert(fioreqctx_iter != fioTransactionsTable.end(), "fio_request_id",
+                                   record.fio_request_id, "No such FIO Request", ErrorRequestContextNotFound);
+
+                    //make sure payer of the request matches the actor.
+                    fio_403_assert(aactor.value == fioreqctx_iter->payer_account, ErrorSignature);
+
+                    fio_400_assert(fioreqctx_iter->fio_data_type == 0, "fio_request_id", record.fio_request_id,
+                                   "Only pending requests can be responded.", ErrorRequestStatusInvalid);
+
+                    fioTransactionsTable.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
+                        fr.fio_data_type = static_cast<int64_t>(trxstatus::sent_to_blockchain);
+                        fr.obt_content = record.content;
+                        fr.obt_time = present_time;
+                    });
+                } else {
+                    const uint64_t id = next_trx_id();
+
+                    fioTransactionsTable.emplace(aactor, [&](struct fiotrxt_info &obtinf) {
+                        obtinf.id = id;
+                        obtinf.payer_fio_addr_hex = payer.namehash;
+                        obtinf.payee_fio_addr_hex = payee.namehash;
+                        obtinf.obt_content = record.content;
+                        obtinf.fio_data_type = static_cast<int64_t>(trxstatus::obt_action);
+                        obtinf.obt_time = present_time;
+                        obtinf.payer_fio_addr = payer_fio_address;
+                        obtinf.payee_fio_addr = record.payee_fio_address;
+                        obtinf.payee_key = payee.encrypt_key;
+                        obtinf.payer_key = payer.encrypt_key;
+                        obtinf.payee_account = payee.owner;
+                        obtinf.payer_account = payer.owner;
+                    });
+                }
+
+                if (!results.empty()) { results += ","; }
+                results += string("{\"status\":\"sent_to_blockchain\"}");
+            }
+
+            const string response_string = string("{\"results\":[") + results + string("]") +
+                                           string(",\"fee_collected\":") + to_string(fee_amount) + string("}");
+
+            if (RECORDOBTRAM > 0) {
+                action(
+                        permission_level{SYSTEMACCOUNT, "active"_n},
+                        "eosio"_n,
+                        "incram"_n,
+                        std::make_tuple(aactor, ramAmount)
+                ).send();
+            }
+
+            fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
+                           "Transaction is too large", ErrorTransactionTooLarge);
+
+            send_response(response_string.c_str());
+        }
+
          /********
           * this action will add a rejection status to the request for funds with the specified request id.
           * the input fiorequest id will be verified to ensure there is a request in the contexts table matching this id
@@ -534,9 +877,8 @@ namespace fioio {
             uint64_t requestId;
             requestId = std::atoi(fio_request_id.c_str());
 
-            auto trxtByRequestId = fioTransactionsTable.get_index<"byrequestid"_n>();
-            auto fioreqctx_iter = trxtByRequestId.find(requestId);
-            fio_400_assert(fioreqctx_iter != trxtByRequestId.end(), "fio_request_id", fio_request_id,
+            auto fioreqctx_iter = find_request(requestId);
+            fio_400_assert(fioreqctx_iter != fioTransactionsTable.end(), "fio_request_id", fio_request_id,
                            "No such FIO Request", ErrorRequestContextNotFound);
 
             fio_400_assert(fioreqctx_iter->fio_data_type == 0, "fio_request_id", fio_request_id,
@@ -574,12 +916,11 @@ namespace fioio {
             fio_403_assert(account == aactor.value, ErrorSignature);
 
             //begin fees, bundle eligible fee logic
-            const uint128_t endpoint_hash = string_to_uint128_hash(REJECT_FUNDS_REQUEST_ENDPOINT);
+            constexpr fee_endpoint endpoint_fee = builtin_fee(REJECT_FUNDS_REQUEST_ENDPOINT);
 
-            auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-            auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+            auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-            fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REJECT_FUNDS_REQUEST_ENDPOINT,
+            fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", REJECT_FUNDS_REQUEST_ENDPOINT,
                            "FIO fee not found for endpoint", ErrorNoEndpoint);
 
             const uint64_t fee_type = fee_iter->type;
@@ -590,12 +931,7 @@ namespace fioio {
             uint64_t fee_amount = 0;
 
             if (fioname_iter->bundleeligiblecountdown > 0) {
-                action{
-                        permission_level{_self, "active"_n},
-                        AddressContract,
-                        "decrcounter"_n,
-                        make_tuple(payer_fio_address, 1)
-                }.send();
+                charge_bundle(_self, fioname_iter->id, 1);
             } else {
                 fee_amount = fee_iter->suf_amount;
                 fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -606,10 +942,7 @@ namespace fioio {
                 process_rewards(tpid, fee_amount, get_self(), aactor);
 
                 if (fee_amount > 0) {
-                    INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                            (SYSTEMACCOUNT, {{_self, "active"_n}},
-                             {aactor, true}
-                            );
+                    queue_power_update(aactor, true, _self);
                 }
             }
             //handle auto proxy
@@ -618,7 +951,7 @@ namespace fioio {
             }
             //end fees, bundle eligible fee logic
 
-            trxtByRequestId.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
+            fioTransactionsTable.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
                 fr.fio_data_type = static_cast<int64_t >(trxstatus::rejected);
                 fr.obt_time = present_time;
             });
@@ -675,9 +1008,8 @@ namespace fioio {
 
         requestId = std::atoi(fio_request_id.c_str());
 
-        auto trxtByRequestId = fioTransactionsTable.get_index<"byrequestid"_n>();
-        auto fioreqctx_iter = trxtByRequestId.find(requestId);
-        fio_400_assert(fioreqctx_iter != trxtByRequestId.end(), "fio_request_id", fio_request_id,
+        auto fioreqctx_iter = find_request(requestId);
+        fio_400_assert(fioreqctx_iter != fioTransactionsTable.end(), "fio_request_id", fio_request_id,
                        "No such FIO Request", ErrorRequestContextNotFound);
 
         const uint128_t payee128FioAddHashed = fioreqctx_iter->payee_fio_addr_hex;
@@ -716,12 +1048,11 @@ namespace fioio {
         fio_403_assert(account == aactor.value, ErrorSignature);
 
         //begin fees, bundle eligible fee logic
-        const uint128_t endpoint_hash = string_to_uint128_hash("cancel_funds_request");
+        constexpr fee_endpoint endpoint_fee = builtin_fee(CANCEL_FUNDS_REQUEST_ENDPOINT);
 
-        auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", "cancel_funds_request",
+        fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", CANCEL_FUNDS_REQUEST_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         const uint64_t fee_type = fee_iter->type;
@@ -732,12 +1063,7 @@ namespace fioio {
         uint64_t fee_amount = 0;
 
         if (fioname_iter->bundleeligiblecountdown > 0) {
-            action{
-                    permission_level{_self, "active"_n},
-                    AddressContract,
-                    "decrcounter"_n,
-                    make_tuple(payee_fio_address, 1)
-            }.send();
+            charge_bundle(_self, fioname_iter->id, 1);
         } else {
             fee_amount = fee_iter->suf_amount;
             fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -748,10 +1074,7 @@ namespace fioio {
             process_rewards(tpid, fee_amount, get_self(), aactor);
 
             if (fee_amount > 0) {
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        (SYSTEMACCOUNT, {{_self, "active"_n}},
-                         {aactor, true}
-                        );
+                queue_power_update(aactor, true, _self);
             }
         }
         //handle auto proxy
@@ -759,7 +1082,7 @@ namespace fioio {
             set_auto_proxy(tpid, 0, get_self(), aactor);
         }
         //end fees, bundle eligible fee logic
-        trxtByRequestId.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
+        fioTransactionsTable.modify(fioreqctx_iter, _self, [&](struct fiotrxt_info &fr) {
             fr.fio_data_type = static_cast<int64_t >(trxstatus::cancelled);
             fr.obt_time = present_time;
         });
@@ -783,5 +1106,6 @@ namespace fioio {
     }
 };
 
-    EOSIO_DISPATCH(FioRequestObt, (migrtrx)(recordobt)(newfundsreq)(rejectfndreq)(cancelfndreq))
+    EOSIO_DISPATCH(FioRequestObt, (migrtrx)(recordobt)(newfundsreq)(rejectfndreq)(cancelfndreq)
+        (setretention)(prunetrx)(batchfndreq)(batchrecobt))
 }
@@ -132,6 +132,26 @@ namespace fioio {
     >
     fiorequest_status_table;
 
+    // the most requests or obt records accepted by one batchfndreq or batchrecobt action.
+    static constexpr size_t MAX_BATCH_ITEMS = 25;
+
+    // one request for funds of a batchfndreq action, the payee is shared by the batch.
+    struct fundsreq_item {
+        string payer_fio_address;
+        string content;
+
+        EOSLIB_SERIALIZE(fundsreq_item, (payer_fio_address)(content))
+    };
+
+    // one obt record of a batchrecobt action, the payer is shared by the batch.
+    struct obt_item {
+        string fio_request_id;
+        string payee_fio_address;
+        string content;
+
+        EOSLIB_SERIALIZE(obt_item, (fio_request_id)(payee_fio_address)(content))
+    };
+
     // The request context table holds the requests for funds that have been requested, it provides
     // searching by id, payer and payee.
     // @abi table fiotrxt_info i64
@@ -152,6 +172,8 @@ namespace fioio {
         string req_content = "";
         string obt_content  = "";
         uint64_t obt_time = 0;
+        //set on rows reduced to a stub by the retention policy, the hash of req_content followed by obt_content.
+        eosio::binary_extension<eosio::checksum256> content_hash;
 
         uint64_t primary_key() const { return id; }
         uint64_t by_requestid() const { return fio_request_id; }
@@ -181,7 +203,7 @@ namespace fioio {
         EOSLIB_SERIALIZE(fiotrxt_info,
         (id)(fio_request_id)(payer_fio_addr_hex)(payee_fio_addr_hex)(fio_data_type)(req_time)
                 (payer_fio_addr)(payee_fio_addr)(payer_key)(payee_key)(payer_account)(payee_account)
-                (req_content)(obt_content)(obt_time)
+                (req_content)(obt_content)(obt_time)(content_hash)
         )
     };
 
@@ -222,4 +244,33 @@ namespace fioio {
     };
 
     typedef multi_index<"migrledgers"_n, migrledger> migrledgers_table;
+
+    // the retention policy for fiotrxtss rows in a terminal state (rejected, sent_to_blockchain, cancelled or
+    // obt_action), these are the rows with an obt_time. rows whose obt_time is more than max_age seconds ago
+    // are removed by prunetrx, or reduced to a stub holding the hash of their content when keep_stub is set.
+    // a max_age of 0 keeps all rows.
+    struct [[eosio::action]] trxretention {
+        uint32_t max_age = 0;
+        bool keep_stub = false;
+        //the obt_time and id of the row at which pruning resumes.
+        uint64_t next_time = 0;
+        uint64_t next_id = 0;
+        uint64_t pruned = 0; //rows removed or reduced to a stub.
+
+        EOSLIB_SERIALIZE(trxretention, (max_age)(keep_stub)(next_time)(next_id)(pruned)
+        )
+    };
+
+    typedef singleton<"trxretention"_n, trxretention> trxretention_singleton;
+
+    // the id of the next fiotrxtss row. ids are handed out from here so that ids freed by prunetrx are
+    // never given to a new request.
+    struct [[eosio::action]] trxidstate {
+        uint64_t next_id = 0;
+
+        EOSLIB_SERIALIZE(trxidstate, (next_id)
+        )
+    };
+
+    typedef singleton<"trxidstate"_n, trxidstate> trxidstate_singleton;
 }
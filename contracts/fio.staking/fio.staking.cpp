@@ -20,14 +20,13 @@ class [[eosio::contract("Staking")]]  Staking: public eosio::contract {
 
 private:
 
+        power_update_sender power_updates;
         //these holds global staking state for fio
         global_staking_singleton         staking;
         global_staking_state             gstaking;
         account_staking_table            accountstaking;
         //access to the voters table for voting info.
         eosiosystem::voters_table        voters;
-        //access to fionames for address info
-        fionames_table                   fionames;
         //access to fio fees for computation of fees.
         fiofee_table                     fiofees;
         //access to general locks to adapt general locks on unstake
@@ -42,7 +41,6 @@ public:
                 accountstaking(_self,_self.value),
                 voters(SYSTEMACCOUNT,SYSTEMACCOUNT.value),
                 fiofees(FeeContract, FeeContract.value),
-                fionames(AddressContract, AddressContract.value),
                 generallocks(SYSTEMACCOUNT,SYSTEMACCOUNT.value){
             gstaking = staking.exists() ? staking.get() : global_staking_state{};
         }
@@ -90,29 +88,28 @@ public:
         require_auth(actor);
         const uint32_t present_time = now();
         uint64_t bundleeligiblecountdown = 0;
+        uint64_t fionameid = 0;
         FioAddress fa;
         getFioAddressStruct(fio_address, fa);
         fio_400_assert(fio_address == "" || validateFioNameFormat(fa), "fio_address", fio_address, "Invalid FIO Address format",
                        ErrorDomainAlreadyRegistered);
 
         if (!fio_address.empty()) {
-            const uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
+            const resolved_address &address = resolve_fio_address(fa.fioaddress);
 
-            fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fa.fioaddress,
+            fio_400_assert(address.found, "fio_address", fa.fioaddress,
                            "FIO Address not registered", ErrorFioNameAlreadyRegistered);
 
-            fio_403_assert(fioname_iter->owner_account == actor.value, ErrorSignature);
-            bundleeligiblecountdown = fioname_iter->bundleeligiblecountdown;
+            fio_403_assert(address.owner == actor.value, ErrorSignature);
+            bundleeligiblecountdown = address.bundleeligiblecountdown;
+            fionameid = address.fionameid;
         }
 
         uint64_t paid_fee_amount = 0;
         bool skipvotecheck = false;
-        const uint128_t endpoint_hash = string_to_uint128_hash(STAKE_FIO_TOKENS_ENDPOINT);
-        auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", STAKE_FIO_TOKENS_ENDPOINT,
+        constexpr fee_endpoint endpoint_fee = builtin_fee(STAKE_FIO_TOKENS_ENDPOINT);
+        auto fee_iter = find_fee(fiofees, endpoint_fee);
+        fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", STAKE_FIO_TOKENS_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
         const int64_t fee_amount = fee_iter->suf_amount;
         const uint64_t fee_type = fee_iter->type;
@@ -120,12 +117,7 @@ public:
                        "unexpected fee type for endpoint stake_fio_tokens, expected 0",
                        ErrorNoEndpoint);
         if (bundleeligiblecountdown > 0) {
-            action{
-                    permission_level{_self, "active"_n},
-                    AddressContract,
-                    "decrcounter"_n,
-                    make_tuple(fio_address, 1)
-            }.send();
+            charge_bundle(_self, fionameid, 1);
         } else {
             paid_fee_amount = fee_iter->suf_amount;
             fio_400_assert(max_fee >= (int64_t)paid_fee_amount, "max_fee", to_string(max_fee), "Fee exceeds supplied maximum.",
@@ -135,10 +127,7 @@ public:
             process_rewards(tpid, fee_amount,get_self(), actor);
 
             if (fee_amount > 0) {
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        ("eosio"_n, {{_self, "active"_n}},
-                         {actor, true}
-                        );
+                queue_power_update(actor, true, _self);
             }
         }
         //End, bundle eligible fee logic for staking
@@ -155,13 +144,11 @@ public:
             //very early by a new account integrated using tpid.
             FioAddress fa1;
             getFioAddressStruct(tpid, fa1);
-            const uint128_t nameHash = string_to_uint128_hash(fa1.fioaddress.c_str());
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
-            fio_400_assert(fioname_iter != namesbyname.end(), "tpid", fa1.fioaddress,
+            const resolved_address &tpidaddress = resolve_fio_address(fa1.fioaddress);
+            fio_400_assert(tpidaddress.found, "tpid", fa1.fioaddress,
                            "FIO Address not registered", ErrorFioNameAlreadyRegistered);
             auto votersbyowner = voters.get_index<"byowner"_n>();
-            const auto viter = votersbyowner.find(fioname_iter->owner_account);
+            const auto viter = votersbyowner.find(tpidaddress.owner);
             if (viter != votersbyowner.end()) {
                 if (viter->is_proxy) {
                     skipvotecheck = true;
@@ -256,18 +243,18 @@ public:
                        ErrorDomainAlreadyRegistered);
 
         uint64_t bundleeligiblecountdown = 0;
+        uint64_t fionameid = 0;
 
         const uint32_t present_time = now();
 
         if (!fio_address.empty()) {
-            const uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-            auto namesbyname = fionames.get_index<"byname"_n>();
-            auto fioname_iter = namesbyname.find(nameHash);
-            fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fa.fioaddress,
+            const resolved_address &address = resolve_fio_address(fa.fioaddress);
+            fio_400_assert(address.found, "fio_address", fa.fioaddress,
                            "FIO Address not registered", ErrorFioNameAlreadyRegistered);
 
-            fio_403_assert(fioname_iter->owner_account == actor.value, ErrorSignature);
-            bundleeligiblecountdown = fioname_iter->bundleeligiblecountdown;
+            fio_403_assert(address.owner == actor.value, ErrorSignature);
+            bundleeligiblecountdown = address.bundleeligiblecountdown;
+            fionameid = address.fionameid;
         }
 
         auto astakebyaccount = accountstaking.get_index<"byaccount"_n>();
@@ -280,10 +267,9 @@ public:
 
         uint64_t paid_fee_amount = 0;
         //begin, bundle eligible fee logic for unstaking
-        const uint128_t endpoint_hash = string_to_uint128_hash(UNSTAKE_FIO_TOKENS_ENDPOINT);
-        auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", UNSTAKE_FIO_TOKENS_ENDPOINT,
+        constexpr fee_endpoint endpoint_fee = builtin_fee(UNSTAKE_FIO_TOKENS_ENDPOINT);
+        auto fee_iter = find_fee(fiofees, endpoint_fee);
+        fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", UNSTAKE_FIO_TOKENS_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
         const int64_t fee_amount = fee_iter->suf_amount;
         const uint64_t fee_type = fee_iter->type;
@@ -293,12 +279,7 @@ public:
                        ErrorNoEndpoint);
 
         if (bundleeligiblecountdown > 0) {
-            action{
-                    permission_level{_self, "active"_n},
-                    AddressContract,
-                    "decrcounter"_n,
-                    make_tuple(fio_address, 1)
-            }.send();
+            charge_bundle(_self, fionameid, 1);
         } else {
             paid_fee_amount = fee_iter->suf_amount;
             fio_400_assert(max_fee >= (int64_t)paid_fee_amount, "max_fee", to_string(max_fee), "Fee exceeds supplied maximum.",
@@ -308,10 +289,7 @@ public:
             process_rewards(tpid, fee_amount,get_self(), actor);
 
             if (fee_amount > 0) {
-                INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                        ("eosio"_n, {{_self, "active"_n}},
-                         {actor, true}
-                        );
+                queue_power_update(actor, true, _self);
             }
         }
         //End, bundle eligible fee logic for staking
@@ -401,10 +379,8 @@ public:
         }
 
         if ((tpid.length() > 0)&&(tpidrewardamount>0)){
-            const uint128_t tnameHash = string_to_uint128_hash(tpid.c_str());
-            auto tnamesbyname = fionames.get_index<"byname"_n>();
-            auto tfioname_iter = tnamesbyname.find(tnameHash);
-            fio_400_assert(tfioname_iter != tnamesbyname.end(), "fio_address", tpid,
+            const resolved_address &tpidaddress = resolve_fio_address(tpid);
+            fio_400_assert(tpidaddress.found, "fio_address", tpid,
                            "FIO Address not registered", ErrorFioNameAlreadyRegistered);
             action(
                     permission_level{get_self(), "active"_n},
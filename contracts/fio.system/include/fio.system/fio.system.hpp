@@ -20,6 +20,7 @@
 
 #include <string>
 #include <deque>
+#include <map>
 #include <type_traits>
 #include <optional>
 
@@ -110,8 +111,10 @@ struct [[eosio::table("global3"), eosio::contract("fio.system")]] eosio_global_s
 
     time_point last_vpay_state_update;
     double total_vpay_share_change_rate = 0;
+    eosio::binary_extension<eosio::checksum256> last_schedule_hash; //hash of the last proposed producer schedule.
 
     EOSLIB_SERIALIZE( eosio_global_state3, (last_vpay_state_update)(total_vpay_share_change_rate)
+            (last_schedule_hash)
     )
 };
 
@@ -173,12 +176,40 @@ struct [[eosio::table, eosio::contract("fio.system")]] locked_tokens_info_v2 {
     std::vector<lockperiodv2> periods;// this is the locking periods for the lock
     uint64_t remaining_lock_amount = 0; //this is the amount remaining in the lock in FIO SUF, get decremented as unlocking occurs.
     uint32_t timestamp = 0; //this is the time of creation of the lock, locking periods are relative to this time.
+    eosio::binary_extension<uint32_t> next_unlock; //until this time there is no unlock to perform, 0 when it must be computed.
+    eosio::binary_extension<uint32_t> final_unlock; //this is the time of the last locking period, clrgenlocked removes the lock after it.
 
     uint64_t primary_key() const { return id; }
     uint64_t by_owner() const{return owner_account.value;}
 
+    //set next_unlock and final_unlock, must be called whenever the periods, payouts or amounts of the lock change.
+    //next_unlock is only recorded while the lock is coherent and every paid out period is in the past, so
+    //computegenerallockedtokens computes the same result without visiting the periods before next_unlock.
+    void set_unlock_times(const uint32_t &present_time) {
+        uint64_t paidamount = 0;
+        uint64_t nextunlock = UINT32_MAX;
+        bool stable = true;
+        for (int i = 0; i < periods.size(); i++) {
+            const uint64_t unlocktime = timestamp + periods[i].duration;
+            if (i < payouts_performed) {
+                if (unlocktime > present_time) {
+                    stable = false;
+                }
+                paidamount += periods[i].amount;
+            } else if (unlocktime < nextunlock) {
+                nextunlock = unlocktime;
+            }
+        }
+        if (!stable || paidamount > lock_amount || remaining_lock_amount != lock_amount - paidamount) {
+            nextunlock = 0;
+        }
+        next_unlock.emplace((uint32_t) nextunlock);
+        final_unlock.emplace(periods.size() == 0 ? 0 : (uint32_t) (timestamp + periods[periods.size() - 1].duration));
+    }
+
     EOSLIB_SERIALIZE( locked_tokens_info_v2, (id)(owner_account)
             (lock_amount)(payouts_performed)(can_vote)(periods)(remaining_lock_amount)(timestamp)
+            (next_unlock)(final_unlock)
     )
 
 };
@@ -190,6 +221,37 @@ typedef eosio::multi_index<"locktokensv2"_n, locked_tokens_info_v2,
 general_locks_table_v2;
 //end general locks
 
+//this table summarizes the token locks of an account, computeusablebalance uses it to skip the
+//lock computations. the locked amounts are valid until next_unlock, the earliest time at which an
+//unlock period of either lock can begin. once the migration is finished an account without a row
+//holds no locks.
+struct [[eosio::table, eosio::contract("fio.system")]] account_restriction {
+    name owner;
+    uint64_t genesis_locked = 0; //the amount locked in lockedtokens
+    uint64_t general_locked = 0; //the amount locked in locktokensv2
+    uint32_t next_unlock = 0; //the locked amounts must be computed again from this time on.
+
+    uint64_t primary_key() const { return owner.value; }
+
+    EOSLIB_SERIALIZE( account_restriction, (owner)(genesis_locked)(general_locked)(next_unlock)
+    )
+};
+
+typedef eosio::multi_index<"acctrestrict"_n, account_restriction>
+account_restrictions_table;
+
+//this is the progress of the migration that summarizes the pre existing locks.
+struct [[eosio::table("restrictmigr"), eosio::contract("fio.system")]] restriction_migration {
+    uint64_t next_genesis = 0; //the next owner to summarize in lockedtokens.
+    uint64_t next_general = 0; //the next id to summarize in locktokensv2.
+    bool finished = false;
+
+    EOSLIB_SERIALIZE( restriction_migration, (next_genesis)(next_general)(finished)
+    )
+};
+
+typedef eosio::singleton<"restrictmigr"_n, restriction_migration> restriction_migration_singleton;
+
 
 //
 
@@ -207,6 +269,27 @@ struct [[eosio::table, eosio::contract("fio.system")]] top_prod_info {
 typedef eosio::multi_index<"topprods"_n, top_prod_info>
 top_producers_table;
 
+struct producer_rank {
+    name owner;
+    double total_votes = 0;
+
+    EOSLIB_SERIALIZE( producer_rank, (owner)(total_votes)
+    )
+};
+
+//the active producers ranked by votes, highest first, at most MAXBPS of them. it is refreshed in
+//update_elected_producers so other contracts can read the ranking without walking prototalvote.
+//last_update is the schedule update that last changed the ranking.
+struct [[eosio::table("prodranking"), eosio::contract("fio.system")]] producer_ranking {
+    std::vector<producer_rank> producers;
+    block_timestamp last_update;
+
+    EOSLIB_SERIALIZE( producer_ranking, (producers)(last_update)
+    )
+};
+
+typedef eosio::singleton<"prodranking"_n, producer_ranking> producer_ranking_singleton;
+
 
 
 struct [[eosio::table, eosio::contract("fio.system")]] producer_info {
@@ -306,11 +389,12 @@ struct [[eosio::table, eosio::contract("fio.system")]] audit_producer_info {
     uint64_t id; //one up id is primary key.
     name account_name; //this is the account name of the producer.
     double voted_fio = 0; //this is the fio voted on this producer.
+    eosio::binary_extension<uint64_t> generation; //audit generation that wrote this record, records of other generations are empty.
 
     uint64_t primary_key() const{return id;}
     uint64_t by_account() const { return account_name.value; }
 
-    EOSLIB_SERIALIZE( audit_producer_info, (id)(account_name)(voted_fio)
+    EOSLIB_SERIALIZE( audit_producer_info, (id)(account_name)(voted_fio)(generation)
     )
 };
 
@@ -328,13 +412,14 @@ struct [[eosio::table, eosio::contract("fio.system")]] audit_proxy_info {
     uint64_t votable_balance = 0; //proxy accounts votable balance (not including proxied vote weight)
     double proxied_vote_weight = 0; //this is the voting power proxied to this proxy
     std::vector <name> producers; //producers voted for by this proxy.
+    eosio::binary_extension<uint64_t> generation; //audit generation that wrote this record, records of other generations are empty.
 
 
     uint64_t primary_key() const{return id;}
     uint64_t by_voterid() const {return voterid;}
 
 
-    EOSLIB_SERIALIZE( audit_proxy_info, (id)(voterid)(votable_balance)(proxied_vote_weight)(producers)
+    EOSLIB_SERIALIZE( audit_proxy_info, (id)(voterid)(votable_balance)(proxied_vote_weight)(producers)(generation)
     )
 };
 
@@ -347,20 +432,26 @@ struct [[eosio::table("auditglobal"), eosio::contract("fio.system")]] audit_glob
     audit_global_info() {}
     int64_t total_voted_fio = 0; //total voted fio
     bool audit_reset = false; //this flag will be set whenever an action affecting voting power is performed by voting accounts.
-    uint64_t current_proxy_id = 0; //this is the id at which to resume proxy analysis.
+                              //it is applied once any finalize in progress completes.
+    uint64_t current_proxy_id = 0; //this is the audit proxy id at which to resume proxy analysis and proxy finalize.
     uint64_t current_voter_id = 0; //this is the id at which to resume voter analysis.
     uint64_t audit_phase = 0;  //the following phases of the audit are identified
                                //    0 -- BEGIN initial deployment. being in this phase means no audit activity has occured yet.
-                               //    1 -- CLEAR clear the audit info. remove all data from the audit system.
+                               //    1 -- CLEAR clear the audit info. starts a new audit generation, records of other
+                               //         generations are treated as empty.
                                //    2 -- ANALYZE_VOTES analyze records in the voters table, rollup results into audit data.
                                //    3 -- ANALYZE_PROXIES analyze proxy voters, rollup results into audit data.
-                               //    4 -- FINALIZE write the audit voting results into FIO state.
+                               //    4 -- FINALIZE_PRODUCERS write the audited producer votes into FIO state.
+                               //    5 -- FINALIZE_PROXIES write the audited proxy weights, then the audited totals into FIO state.
     double total_producer_vote_weight = 0; // this is the total fio voted on producers.
-
+    eosio::binary_extension<uint64_t> audit_generation; //generation of the audit in progress, bumped by phase 1.
+                                                        //audit records written before generations existed read as generation 0.
+    eosio::binary_extension<uint64_t> current_audit_producer_id; //this is the audit producer id at which to resume producer finalize.
 
 
     EOSLIB_SERIALIZE( audit_global_info,(total_voted_fio)
             (audit_reset)(current_proxy_id)(current_voter_id)(audit_phase)(total_producer_vote_weight)
+            (audit_generation)(current_audit_producer_id)
     )
 };
 
@@ -381,11 +472,15 @@ static constexpr uint32_t seconds_per_day = 24 * 3600;
 class [[eosio::contract("fio.system")]] system_contract : public native {
 
 private:
+    fioio::power_update_sender _power_updates;
     voters_table _voters;
     producers_table _producers;
     top_producers_table _topprods;
+    producer_ranking_singleton _prodranking;
     locked_tokens_table _lockedtokens;
     general_locks_table_v2 _generallockedtokens;
+    account_restrictions_table _restrictions;
+    restriction_migration_singleton _restrictmigr;
    //MAS-522 eliminate producers2 producers_table2 _producers2;
     global_state_singleton _global;
     global_state2_singleton _global2;
@@ -401,6 +496,14 @@ private:
     audit_global_singleton _auditglobal;
     audit_proxy_table _auditproxy;
     audit_producer_table _auditproducer;
+    //packed global state as loaded, the singletons are only written back when their contents change.
+    std::vector<char> _gstate_loaded;
+    std::vector<char> _gstate2_loaded;
+    std::vector<char> _gstate3_loaded;
+    std::vector<char> _audit_global_loaded;
+    //votable balances computed during this action, keyed by account. balances do not change during a
+    //system action, the entry of an account is dropped when its locks change in update_restriction or unlock_tokens.
+    std::map<uint64_t, uint64_t> _votable_balances;
 
 
 public:
@@ -448,6 +551,10 @@ public:
     [[eosio::action]]
     void clrgenlocked(const name &owner);
 
+    //summarize the locks of accounts that held locks before the restriction summary existed.
+    [[eosio::action]]
+    void migrrestrict(const uint16_t &amount, const name &actor);
+
     [[eosio::action]]
     void setnolimits(const name &account);
 
@@ -583,6 +690,12 @@ private:
 
     static block_timestamp current_block_time();
 
+    void record_restriction(const name &owner);
+
+    void update_restriction(const name &owner);
+
+    uint32_t next_unlock_time(const name &owner);
+
     // defined in delegate_bandwidth.cpp
     void changebw(name from, name receiver,
                   asset stake_net_quantity, asset stake_cpu_quantity, bool transfer);
@@ -594,7 +707,9 @@ private:
 
     uint64_t get_votable_balance(const name &tokenowner);
 
-    void unlock_tokens(const name &actor);
+    uint64_t compute_votable_balance(const name &tokenowner);
+
+    void unlock_tokens(const name &owner);
 
     void update_last_vote_weight(const name &voter);
 
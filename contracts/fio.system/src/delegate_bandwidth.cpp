@@ -87,6 +87,18 @@ namespace eosiosystem {
              return;
         }
 
+        //the vote weight did not change, update_votes would apply zero deltas to the proxies, producers
+        //and global tallies. any change, however small, goes through update_votes so the tallies stay exact.
+        if (!(voter_itr->proxy && voter_itr->producers.size())) {
+            double new_vote_weight = (double)get_votable_balance(voter);
+            if (voter_itr->is_proxy) {
+                new_vote_weight += voter_itr->proxied_vote_weight;
+            }
+            if (new_vote_weight == voter_itr->last_vote_weight) {
+                return;
+            }
+        }
+
         if (voter_itr->producers.size() || voter_itr->proxy) {
             update_votes(voter, voter_itr->proxy, voter_itr->producers, false);
         }else {
@@ -23,11 +23,14 @@ namespace eosiosystem {
               _voters(_self, _self.value),
               _producers(_self, _self.value),
               _topprods(_self, _self.value),
+              _prodranking(_self, _self.value),
               _global(_self, _self.value),
               _global2(_self, _self.value),
               _global3(_self, _self.value),
               _lockedtokens(_self,_self.value),
               _generallockedtokens(_self, _self.value),
+              _restrictions(_self, _self.value),
+              _restrictmigr(_self, _self.value),
               _fionames(AddressContract, AddressContract.value),
               _domains(AddressContract, AddressContract.value),
               _accountmap(AddressContract, AddressContract.value),
@@ -35,10 +38,32 @@ namespace eosiosystem {
               _auditglobal(_self,_self.value),
               _auditproxy(_self,_self.value),
               _auditproducer(_self,_self.value){
-        _gstate = _global.exists() ? _global.get() : get_default_parameters();
-        _gstate2 = _global2.exists() ? _global2.get() : eosio_global_state2{};
-        _gstate3 = _global3.exists() ? _global3.get() : eosio_global_state3{};
-        _audit_global_info = _auditglobal.exists() ? _auditglobal.get() : audit_global_info{};
+        //keep the packed state as loaded, a singleton that does not exist yet keeps an empty
+        //snapshot so it is always written by the destructor.
+        if (_global.exists()) {
+            _gstate = _global.get();
+            _gstate_loaded = eosio::pack(_gstate);
+        } else {
+            _gstate = get_default_parameters();
+        }
+        if (_global2.exists()) {
+            _gstate2 = _global2.get();
+            _gstate2_loaded = eosio::pack(_gstate2);
+        } else {
+            _gstate2 = eosio_global_state2{};
+        }
+        if (_global3.exists()) {
+            _gstate3 = _global3.get();
+            _gstate3_loaded = eosio::pack(_gstate3);
+        } else {
+            _gstate3 = eosio_global_state3{};
+        }
+        if (_auditglobal.exists()) {
+            _audit_global_info = _auditglobal.get();
+            _audit_global_loaded = eosio::pack(_audit_global_info);
+        } else {
+            _audit_global_info = audit_global_info{};
+        }
     }
 
     eosiosystem::eosio_global_state eosiosystem::system_contract::get_default_parameters() {
@@ -63,10 +88,10 @@ namespace eosiosystem {
     }
 
     eosiosystem::system_contract::~system_contract() {
-        _global.set(_gstate, _self);
-        _global2.set(_gstate2, _self);
-        _global3.set(_gstate3, _self);
-        _auditglobal.set(_audit_global_info,_self);
+        if (eosio::pack(_gstate) != _gstate_loaded) _global.set(_gstate, _self);
+        if (eosio::pack(_gstate2) != _gstate2_loaded) _global2.set(_gstate2, _self);
+        if (eosio::pack(_gstate3) != _gstate3_loaded) _global3.set(_gstate3, _self);
+        if (eosio::pack(_audit_global_info) != _audit_global_loaded) _auditglobal.set(_audit_global_info,_self);
     }
 
     void eosiosystem::system_contract::setparams(const eosio::blockchain_parameters &params) {
@@ -192,11 +217,10 @@ namespace eosiosystem {
         }
 
 
-        const uint128_t endpoint_hash = string_to_uint128_hash(NEW_FIO_CHAIN_ACCOUNT_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(NEW_FIO_CHAIN_ACCOUNT_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", NEW_FIO_CHAIN_ACCOUNT_ENDPOINT,
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", NEW_FIO_CHAIN_ACCOUNT_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         const uint64_t reg_amount = fee_iter->suf_amount;
@@ -359,6 +383,7 @@ namespace eosiosystem {
                 a.remaining_locked_amount = amount;
                 a.timestamp = now();
             });
+        update_restriction(owner);
         //return status added for staking, to permit unit testing using typescript sdk.
         const string response_string = string("{\"status\": \"OK\"}");
         send_response(response_string.c_str());
@@ -405,7 +430,9 @@ namespace eosiosystem {
             a.periods = periods;
             a.remaining_lock_amount = amount;
             a.timestamp = now();
+            a.set_unlock_times(now());
         });
+        update_restriction(owner);
     }
 
     void eosiosystem::system_contract::modgenlocked(const name &owner, const vector<lockperiodv2> &periods,
@@ -447,8 +474,9 @@ namespace eosiosystem {
             av.lock_amount = amount;
             av.payouts_performed = payouts;
             av.periods = periods;
-
+            av.set_unlock_times(now());
         });
+        update_restriction(owner);
     }
 
 
@@ -492,7 +520,9 @@ namespace eosiosystem {
             av.periods = periods;
             av.remaining_lock_amount = amount;
             av.timestamp = now();
+            av.set_unlock_times(now());
         });
+        update_restriction(owner);
     }
 
     //fip48
@@ -507,7 +537,7 @@ namespace eosiosystem {
             auto realloc_lockiter = _lockedtokens.find(vectorit->account.value);
             check(realloc_lockiter != _lockedtokens.end(),"NOWORK FIP-48 could not find reallocation account in lockedtokens.");
             _lockedtokens.erase(realloc_lockiter);
-
+            update_restriction(vectorit->account);
         }
         //adapt the receiver locks
         auto lockiter = _lockedtokens.find(fip48recevingaccount.value);
@@ -517,6 +547,7 @@ namespace eosiosystem {
             a.total_grant_amount += fip48expectedtotaltransferamount;
             a.remaining_locked_amount += fip48expectedtotaltransferamount;
         });
+        update_restriction(fip48recevingaccount);
     }
 
     //this action will check if all periods are in the past and clear the general locks if all of them are in the past.
@@ -530,6 +561,7 @@ namespace eosiosystem {
         check(is_account(owner), "account must pre exist");
         auto locks_by_owner = _generallockedtokens.get_index<"byowner"_n>();
         auto lockiter = locks_by_owner.find(owner.value);
+        bool cleared = false;
         if (lockiter != locks_by_owner.end()) {
             uint32_t present_time = now();
             //never clear another accounts stuff.
@@ -537,8 +569,136 @@ namespace eosiosystem {
                 (((lockiter->periods[lockiter->periods.size() - 1].duration + lockiter->timestamp) < present_time) ||
                  lockiter->periods.size() == 0)) {
                 locks_by_owner.erase(lockiter);
+                cleared = true;
             }
         }
+        //this runs for every fee paid, so the summary is only computed again once it has expired.
+        auto restrict_iter = _restrictions.find(owner.value);
+        if (cleared || (restrict_iter != _restrictions.end() && now() >= restrict_iter->next_unlock)) {
+            update_restriction(owner);
+        }
+    }
+
+    //this action records the accounts holding locks before the restriction summary existed, genesis locks
+    //are visited first and then general locks. the lock tables are only read, the recorded summary has a
+    //next_unlock of 0 so it is computed again by update_restriction before it is used. computeusablebalance
+    //uses the summary of accounts without locks only once the migration is finished.
+    void eosiosystem::system_contract::migrrestrict(const uint16_t &amount, const name &actor) {
+        require_auth(actor);
+
+        auto prodbyowner = _producers.get_index<"byowner"_n>();
+        fio_400_assert(prodbyowner.find(actor.value) != prodbyowner.end(), "actor", actor.to_string(),
+                       "Actor not active producer", ErrorNoFioAddressProducer);
+
+        restriction_migration migr = _restrictmigr.get_or_default();
+        fio_400_assert(!migr.finished, "migrrestrict", "migrrestrict", "No Work.", ErrorNoWork);
+
+        const uint16_t limit = amount > 25 ? 25 : amount;
+        uint16_t count = 0;
+        auto genesis_iter = _lockedtokens.lower_bound(migr.next_genesis);
+        while (genesis_iter != _lockedtokens.end() && count < limit) {
+            record_restriction(genesis_iter->owner);
+            migr.next_genesis = genesis_iter->owner.value + 1;
+            count++;
+            genesis_iter++;
+        }
+        if (genesis_iter == _lockedtokens.end()) {
+            auto general_iter = _generallockedtokens.lower_bound(migr.next_general);
+            while (general_iter != _generallockedtokens.end() && count < limit) {
+                record_restriction(general_iter->owner_account);
+                migr.next_general = general_iter->id + 1;
+                count++;
+                general_iter++;
+            }
+            migr.finished = general_iter == _generallockedtokens.end();
+        }
+        _restrictmigr.set(migr, _self);
+
+        const string response_string = string("{\"status\": \"OK\",\"migrated\":") +
+                                       to_string(count) + string("}");
+
+        fio_400_assert(transaction_size() <= MAX_TRX_SIZE, "transaction_size", std::to_string(transaction_size()),
+                       "Transaction is too large", ErrorTransaction);
+
+        send_response(response_string.c_str());
+    }
+
+    //add a restriction summary for the owner that must be computed before it is used, an existing summary is kept.
+    void eosiosystem::system_contract::record_restriction(const name &owner) {
+        if (_restrictions.find(owner.value) == _restrictions.end()) {
+            _restrictions.emplace(_self, [&](struct account_restriction &a) {
+                a.owner = owner;
+                a.next_unlock = 0;
+            });
+        }
+    }
+
+    //compute the locked amounts of the owner and record them in the restriction summary, the summary
+    //row is removed when the owner holds no locks. must be called whenever the locks of the owner change.
+    void eosiosystem::system_contract::update_restriction(const name &owner) {
+        _votable_balances.erase(owner.value);
+        const uint64_t genesislocked = eosio::token::computeremaininglockedtokens(owner, true);
+        const uint64_t generallocked = eosio::token::computegenerallockedtokens(owner, true);
+
+        auto restrict_iter = _restrictions.find(owner.value);
+        auto locks_by_owner = _generallockedtokens.get_index<"byowner"_n>();
+        if (_lockedtokens.find(owner.value) == _lockedtokens.end() &&
+            locks_by_owner.find(owner.value) == locks_by_owner.end()) {
+            if (restrict_iter != _restrictions.end()) {
+                _restrictions.erase(restrict_iter);
+            }
+            return;
+        }
+
+        const uint32_t nextunlock = next_unlock_time(owner);
+        if (restrict_iter == _restrictions.end()) {
+            _restrictions.emplace(_self, [&](struct account_restriction &a) {
+                a.owner = owner;
+                a.genesis_locked = genesislocked;
+                a.general_locked = generallocked;
+                a.next_unlock = nextunlock;
+            });
+        } else {
+            _restrictions.modify(restrict_iter, _self, [&](struct account_restriction &a) {
+                a.genesis_locked = genesislocked;
+                a.general_locked = generallocked;
+                a.next_unlock = nextunlock;
+            });
+        }
+    }
+
+    //this is the earliest time at which the computed genesis or general locked amounts of the owner can change.
+    //the genesis boundaries follow computeremaininglockedtokens, day 90 and every 180 days after it.
+    uint32_t eosiosystem::system_contract::next_unlock_time(const name &owner) {
+        const uint32_t present_time = now();
+        uint64_t nextunlock = UINT32_MAX;
+
+        auto lockiter = _lockedtokens.find(owner.value);
+        if (lockiter != _lockedtokens.end() &&
+            !(lockiter->inhibit_unlocking && (lockiter->grant_type == 2)) &&
+            lockiter->unlocked_period_count < 6) {
+            const uint64_t daysSinceGrant = (present_time - lockiter->timestamp) / SECONDSPERDAY;
+            uint64_t nextday = 90;
+            if (daysSinceGrant >= 90) {
+                nextday = 90 + (((daysSinceGrant - 90) / 180) + 1) * 180;
+            }
+            if (nextday <= 90 + (6 * 180)) {
+                nextunlock = std::min(nextunlock, lockiter->timestamp + (nextday * SECONDSPERDAY));
+            }
+        }
+
+        auto locks_by_owner = _generallockedtokens.get_index<"byowner"_n>();
+        auto genlockiter = locks_by_owner.find(owner.value);
+        if (genlockiter != locks_by_owner.end() && genlockiter->payouts_performed < genlockiter->periods.size()) {
+            for (int i = 0; i < genlockiter->periods.size(); i++) {
+                const uint64_t unlocktime = genlockiter->timestamp + genlockiter->periods[i].duration;
+                if (unlocktime > present_time) {
+                    nextunlock = std::min(nextunlock, unlocktime);
+                    break;
+                }
+            }
+        }
+        return (uint32_t) nextunlock;
     }
 
     int system_contract::addtoproducervote(const name &voter,
@@ -550,6 +710,7 @@ namespace eosiosystem {
         check(weight >= 0,"cannot use weight less than 0. account "+voter.to_string());
 
         auto auditprodbyaccount = _auditproducer.get_index<"byaccount"_n>();
+        const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
 
         for(name prodnm : producers) {
             auto auditprodacct_iter = auditprodbyaccount.find(prodnm.value);
@@ -559,9 +720,16 @@ namespace eosiosystem {
                     p.id = id;
                     p.account_name = prodnm;
                     p.voted_fio = weight;
+                    p.generation.emplace(generation);
                 });
 
 
+            } else if (auditprodacct_iter->generation.value_or(0) != generation) {
+                //record left by an older audit, overwrite it.
+                auditprodbyaccount.modify(auditprodacct_iter, _self, [&](struct audit_producer_info &a) {
+                    a.voted_fio = weight;
+                    a.generation.emplace(generation);
+                });
             } else {
                 auditprodbyaccount.modify(auditprodacct_iter, _self, [&](struct audit_producer_info &a) {
                     a.voted_fio += weight;
@@ -588,6 +756,7 @@ namespace eosiosystem {
         //get the voter from the audit proxy table.
         auto auditproxybyvoterid = _auditproxy.get_index<"byvotererid"_n>();
         auto auditproxy_iter = auditproxybyvoterid.find(voterid);
+        const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
 
         //if the record does not exist then create it.
         if(auditproxy_iter == auditproxybyvoterid.end()) {
@@ -598,6 +767,15 @@ namespace eosiosystem {
                 p.votable_balance = votable_balance;
                 p.proxied_vote_weight = 0;
                 p.producers = producers;
+                p.generation.emplace(generation);
+            });
+            //if the record is left by an older audit, overwrite it.
+        } else if (auditproxy_iter->generation.value_or(0) != generation) {
+            auditproxybyvoterid.modify(auditproxy_iter, _self, [&](struct audit_proxy_info &a) {
+                a.votable_balance = votable_balance;
+                a.proxied_vote_weight = 0;
+                a.producers = producers;
+                a.generation.emplace(generation);
             });
             //if the record does exist, just add the producers that have been voted for by this voter.
         } else {
@@ -626,6 +804,7 @@ namespace eosiosystem {
 
         auto auditproxybyvoterid = _auditproxy.get_index<"byvotererid"_n>();
         auto auditproxy_iter = auditproxybyvoterid.find(voterid);
+        const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
 
         //if the audit proxy record does not exist then update the summary info for the proxy.
         //the voterid and the weight.
@@ -635,11 +814,20 @@ namespace eosiosystem {
                 p.id = id;
                 p.voterid = voterid;
                 p.proxied_vote_weight = weight;
+                p.generation.emplace(generation);
                 //no producers are set here!!,
                 // producers get set later when we see a proxy that has voted.
                 // just a note we check that producers is not empty when adding proxy to producer vote
                 //during the write of the audit.
             });
+        } else if (auditproxy_iter->generation.value_or(0) != generation) {
+            //record left by an older audit, overwrite it with this weight only.
+            auditproxybyvoterid.modify(auditproxy_iter, _self, [&](struct audit_proxy_info &a) {
+                a.votable_balance = 0;
+                a.proxied_vote_weight = weight;
+                a.producers.clear();
+                a.generation.emplace(generation);
+            });
         } else {
             //if the record exists then just add the weight to the proxied weight.
             auditproxybyvoterid.modify(auditproxy_iter, _self, [&](struct audit_proxy_info &a) {
@@ -654,10 +842,11 @@ namespace eosiosystem {
 
     //begin audit machine
     // call this action repeatedly and it will progress through the process of auditing the FIO vote.
-    // phase 1, clear any previous audit data, phase 2 analyze the voters table contents iteratively on each call
+    // phase 1, start a new audit generation so previous audit data reads as empty, phase 2 analyze the voters table contents iteratively on each call
     // build a summary of proxy voting weight and producer vote weight for non proxy voters, phase 3 roll up the proxy summary
-    // into the producer vote weight, phase 4 write the audited vote out to the fio blockchain and update the vote with
-    // the results of the audit.
+    // into the producer vote weight, phase 4 write the audited producer votes, phase 5 write the audited proxy weights
+    // and then the audited totals. phases 4 and 5 are batched like phase 3 and reap records of other audit
+    // generations as they pass them.
     void eosiosystem::system_contract::auditvote(const name &actor,  const int64_t &max_fee){
         string response_string ="";
 
@@ -671,11 +860,10 @@ namespace eosiosystem {
         check(auditaccount_iter == votersbyowner.end()," cannot call auditvote using an account that has voted, please use an account that has not voted.\n");
 
         //fees and ram bump
-        const uint128_t endpoint_hash = string_to_uint128_hash(AUDIT_VOTE_FEE_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(AUDIT_VOTE_FEE_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", AUDIT_VOTE_FEE_ENDPOINT,
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", AUDIT_VOTE_FEE_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         const uint64_t reg_amount = fee_iter->suf_amount;
@@ -689,13 +877,21 @@ namespace eosiosystem {
                        "Fee exceeds supplied maximum.",
                        ErrorMaxFeeExceeded);
 
-        //get audit state.
-       if( _audit_global_info.audit_reset){
+        //get audit state. a reset waits while the audited values are written (phases 4 and 5), restarting there
+        //would leave some producers and proxies with audited values and others without. the reset stays pending
+        //and starts a new audit once the finalize completes, which corrects the votes made during the finalize.
+       if( _audit_global_info.audit_reset && _audit_global_info.audit_phase != 4 &&
+           _audit_global_info.audit_phase != 5){
            _audit_global_info.audit_reset = false;
            _audit_global_info.audit_phase = 1;
 
        }
 
+       //binary extensions are only serialized up to the first one without a value, give each a value
+       //before any later one is written.
+       _audit_global_info.audit_generation.emplace(_audit_global_info.audit_generation.value_or(0));
+       _audit_global_info.current_audit_producer_id.emplace(_audit_global_info.current_audit_producer_id.value_or(0));
+
        //init to 2 read the voters table for the calling account and verify not in voters table.
         int operationcount = 2;
         int recordcount = 0;
@@ -706,26 +902,14 @@ namespace eosiosystem {
                //always fall through to phase 1
            }
            case 1: {
-               //phase 1 is assumed to execute in one block, if it cannot then phase 4 will also fail to transact,
-               // so no number of operation checks are performed on phase 1, we just clear the data.
-               //clear all audit_global_info values.
+               //clear all audit_global_info values. audit producer and audit proxy records are not removed here,
+               //bumping the generation makes them read as empty, later phases overwrite them or reap them.
                _audit_global_info.total_voted_fio = 0;
                _audit_global_info.current_proxy_id = 0;
                _audit_global_info.current_voter_id = 0;
                _audit_global_info.total_producer_vote_weight = 0;
-               recordcount = 4;
-
-
-               //remove all audit producers records.
-               for (auto idx = _auditproducer.begin(); idx != _auditproducer.end();) {
-                       idx = _auditproducer.erase(idx);
-                       recordcount++;
-               }
-               //remove all audit proxy records.
-               for (auto idx2 = _auditproxy.begin(); idx2 != _auditproxy.end();) {
-                   idx2 = _auditproxy.erase(idx2);
-                   recordcount++;
-               }
+               _audit_global_info.audit_generation.emplace(_audit_global_info.audit_generation.value_or(0) + 1);
+               recordcount = 5;
 
                _audit_global_info.audit_phase = 2;
                recordcount++;
@@ -849,15 +1033,17 @@ namespace eosiosystem {
                break;
            }
            case 3: {
-               uint64_t stopidx = _auditproxy.available_primary_key();
-
-               uint64_t id = _audit_global_info.current_proxy_id;
-
-               while( id < stopidx) {
-                   //get the auditproxy by id from voters table
-                   auto audproxy = _auditproxy.find(id);
-                   //if this error happens then vote with any account on chain to reset the audit!!!!
-                   check(audproxy != _auditproxy.end(),"failed to find auditproxy id "+to_string(id)+"\n");
+               const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
+
+               auto audproxy = _auditproxy.lower_bound(_audit_global_info.current_proxy_id);
+               while (audproxy != _auditproxy.end()) {
+                   //records of older audit generations are empty, skip them.
+                   if (audproxy->generation.value_or(0) != generation) {
+                       operationcount++;
+                       audproxy++;
+                       if(operationcount >= 120) break;
+                       continue;
+                   }
 
                    auto voter = _voters.find(audproxy->voterid);
                    //if the voter id is not found in the voters table we just go to the next one.
@@ -870,13 +1056,15 @@ namespace eosiosystem {
                        operationcount += addtoproducervote(voter->owner,audproxy->proxied_vote_weight, audproxy->producers);
                    }
 
-                   id++;
+                   audproxy++;
                    recordcount++;
                    if(operationcount >= 120) break;
                } //end loop
-               _audit_global_info.current_proxy_id = id;
-               if (id >= stopidx) {
+               if (audproxy == _auditproxy.end()) {
+                   _audit_global_info.current_audit_producer_id.emplace(0);
                    _audit_global_info.audit_phase = 4;
+               } else {
+                   _audit_global_info.current_proxy_id = audproxy->id;
                }
                // Return computed status string.
                response_string = string("{\"status\": \"OK\",\"audit_phase\":\"") +
@@ -887,10 +1075,18 @@ namespace eosiosystem {
                break;
            }
            case 4: {
-
                auto producersbyaccount = _producers.get_index<"byowner"_n>();
+               const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
 
-               for (auto idx = _auditproducer.begin(); idx != _auditproducer.end(); idx++) {
+               auto idx = _auditproducer.lower_bound(_audit_global_info.current_audit_producer_id.value_or(0));
+               while (idx != _auditproducer.end()) {
+                   //records of other audit generations are reaped as they are passed.
+                   if (idx->generation.value_or(0) != generation) {
+                       idx = _auditproducer.erase(idx);
+                       operationcount++;
+                       if(operationcount >= 120) break;
+                       continue;
+                   }
                    auto producer_iter = producersbyaccount.find(idx->account_name.value);
                    //if the producer is not found, do not complete
                    //if this error happens then vote with any account on chain to reset the audit!!!!
@@ -899,33 +1095,68 @@ namespace eosiosystem {
                    producersbyaccount.modify(producer_iter, _self, [&](struct producer_info &p) {
                        p.total_votes = idx->voted_fio;
                    });
+                   operationcount += 2;
+                   idx++;
+                   recordcount++;
+                   if(operationcount >= 120) break;
                }
+               if (idx == _auditproducer.end()) {
+                   _audit_global_info.current_audit_producer_id.emplace(0);
+                   _audit_global_info.current_proxy_id = 0;
+                   _audit_global_info.audit_phase = 5;
+               } else {
+                   _audit_global_info.current_audit_producer_id.emplace(idx->id);
+               }
+               response_string = string("{\"status\": \"OK\",\"audit_phase\":\"") +
+                                 to_string(_audit_global_info.audit_phase) + string("\",\"records_processed\": ") +
+                                 to_string(recordcount) + string(",\"fee_collected\":") +
+                                 to_string(reg_amount) + string("}");
 
-               for (auto idx2 = _auditproxy.begin(); idx2 != _auditproxy.end(); idx2++) {
-                   auto voter = _voters.find(idx2->voterid);
+               break;
+           }
+           case 5: {
+               const uint64_t generation = _audit_global_info.audit_generation.value_or(0);
+
+               auto idx = _auditproxy.lower_bound(_audit_global_info.current_proxy_id);
+               while (idx != _auditproxy.end()) {
+                   //records of other audit generations are reaped as they are passed.
+                   if (idx->generation.value_or(0) != generation) {
+                       idx = _auditproxy.erase(idx);
+                       operationcount++;
+                       if(operationcount >= 120) break;
+                       continue;
+                   }
+                   auto voter = _voters.find(idx->voterid);
                    //if the voter id is not found this is an incoherency in the audit. do not complete.
                    //if this error happens then vote with any account on chain to reset the audit!!!!
-                   check (voter != _voters.end(),"failed to find proxy in voters table voterid "+to_string(idx2->voterid)+"\n");
+                   check (voter != _voters.end(),"failed to find proxy in voters table voterid "+to_string(idx->voterid)+"\n");
                    //set proxy vote weight. and last vote weight.
-                   double last_vote_weight = (double)(idx2->votable_balance);
+                   double last_vote_weight = (double)(idx->votable_balance);
                    if(voter->is_proxy) {
-                      last_vote_weight +=  idx2->proxied_vote_weight;
+                      last_vote_weight +=  idx->proxied_vote_weight;
                    }
                    _voters.modify(voter, _self, [&](struct voter_info &a) {
                        a.last_vote_weight = last_vote_weight;
-                       a.proxied_vote_weight = idx2->proxied_vote_weight;
+                       a.proxied_vote_weight = idx->proxied_vote_weight;
                    });
+                   operationcount += 2;
+                   idx++;
+                   recordcount++;
+                   if(operationcount >= 120) break;
+               }
+               if (idx == _auditproxy.end()) {
+                   //every audited value is written, the audit is complete.
+                   _gstate.total_voted_fio = _audit_global_info.total_voted_fio;
+                   _gstate.total_producer_vote_weight =  _audit_global_info.total_producer_vote_weight;
+                   _audit_global_info.current_proxy_id = 0;
+                   _audit_global_info.audit_phase = 1;
+               } else {
+                   _audit_global_info.current_proxy_id = idx->id;
                }
-
-               _gstate.total_voted_fio = _audit_global_info.total_voted_fio;
-               _gstate.total_producer_vote_weight =  _audit_global_info.total_producer_vote_weight;
-
-               _audit_global_info.audit_phase = 1;
                response_string = string("{\"status\": \"OK\",\"audit_phase\":\"") +
-                       to_string(_audit_global_info.audit_phase) + string("\",\"records_processed\": ") +
-                                              to_string(0) + string(",\"fee_collected\":") +
-                                              to_string(reg_amount) + string("}");
-
+                                 to_string(_audit_global_info.audit_phase) + string("\",\"records_processed\": ") +
+                                 to_string(recordcount) + string(",\"fee_collected\":") +
+                                 to_string(reg_amount) + string("}");
 
                break;
            }
@@ -968,7 +1199,7 @@ EOSIO_DISPATCH( eosiosystem::system_contract,
 // native.hpp (newaccount definition is actually in fio.system.cpp)
 (newaccount)(addaction)(remaction)(updateauth)(deleteauth)(linkauth)(unlinkauth)(canceldelay)(onerror)(setabi)
 // fio.system.cpp
-(init)(setnolimits)(addlocked)(addgenlocked)(modgenlocked)(ovrwrtgenlck)(clrgenlocked)(setparams)(setpriv)
+(init)(setnolimits)(addlocked)(addgenlocked)(modgenlocked)(ovrwrtgenlck)(clrgenlocked)(migrrestrict)(setparams)(setpriv)
         (rmvproducer)(updtrevision)(newfioacc)(auditvote)(resetaudit)
         (fipxlviiilck)
 // delegate_bandwidth.cpp
@@ -164,24 +164,17 @@ namespace eosiosystem {
         FioAddress fa;
         getFioAddressStruct(fio_address, fa);
 
-        uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-        uint128_t domainHash = string_to_uint128_hash(fa.fiodomain.c_str());
-
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto fioname_iter = namesbyname.find(nameHash);
-        fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
+        const resolved_address &address = resolve_fio_address(fa.fioaddress);
+        fio_400_assert(address.found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint64_t account = fioname_iter->owner_account;
+        uint64_t account = address.owner;
         fio_403_assert(account == actor.value, ErrorSignature);
 
-        auto domainsbyname = _domains.get_index<"byname"_n>();
-        auto domains_iter = domainsbyname.find(domainHash);
-
-        fio_400_assert(domains_iter != domainsbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.domain_found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint32_t expiration = domains_iter->expiration;
+        uint32_t expiration = address.domain_expiration;
 
         //add 30 days to the domain expiration, this call will work until 30 days past expire.
         expiration = get_time_plus_seconds(expiration,SECONDS30DAYS);
@@ -193,12 +186,11 @@ namespace eosiosystem {
 
         //TODO: REFACTOR FEE ( PROXY / PRODUCER )
         //begin new fees, logic for Mandatory fees.
-        uint128_t endpoint_hash = string_to_uint128_hash(REGISTER_PRODUCER_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(REGISTER_PRODUCER_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
         //if the fee isnt found for the endpoint, then 400 error.
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REGISTER_PRODUCER_ENDPOINT,
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", REGISTER_PRODUCER_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -248,25 +240,18 @@ namespace eosiosystem {
         FioAddress fa;
         getFioAddressStruct(fio_address, fa);
 
-        uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-        uint128_t domainHash = string_to_uint128_hash(fa.fiodomain.c_str());
-
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto fioname_iter = namesbyname.find(nameHash);
+        const resolved_address &address = resolve_fio_address(fa.fioaddress);
 
-        fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint64_t account = fioname_iter->owner_account;
+        uint64_t account = address.owner;
         fio_403_assert(account == actor.value, ErrorSignature);
 
-        auto domainsbyname = _domains.get_index<"byname"_n>();
-        auto domains_iter = domainsbyname.find(domainHash);
-
-        fio_400_assert(domains_iter != domainsbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.domain_found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint32_t expiration = domains_iter->expiration;
+        uint32_t expiration = address.domain_expiration;
         fio_400_assert(now() <= expiration, "domain", fa.fiodomain, "FIO Domain expired",
                        ErrorDomainExpired);
 
@@ -281,12 +266,11 @@ namespace eosiosystem {
         });
 
         //begin new fees, logic for Mandatory fees.
-        uint128_t endpoint_hash = string_to_uint128_hash(UNREGISTER_PRODUCER_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(UNREGISTER_PRODUCER_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
         //if the fee isnt found for the endpoint, then 400 error.
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", UNREGISTER_PRODUCER_ENDPOINT,
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", UNREGISTER_PRODUCER_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -327,37 +311,50 @@ namespace eosiosystem {
       std::vector< value_type > top_producers;
       top_producers.reserve(MAXACTIVEBPS);
 
+      //the present top producers, topprods iterates by producer name so these are sorted.
       vector<name> prevprods;
-
-      //clear _topprods table
-      auto iter = _topprods.begin();
-      while (iter != _topprods.end()) {
+      for (auto iter = _topprods.begin(); iter != _topprods.end(); iter++) {
           prevprods.push_back(iter->producer);
-          iter = _topprods.erase(iter);
-
       }
-
-      for( auto it = idx.cbegin(); it != idx.cend() && top_producers.size() < MAXACTIVEBPS && 0 < it->total_votes && it->active(); ++it ) {
+      vector<bool> stillelected(prevprods.size(), false);
+      bool prodschanged = false;
+
+      producer_ranking ranking;
+      ranking.producers.reserve(MAXBPS);
+      ranking.last_update = block_time;
+
+      //only producers entering or leaving the top producers are written.
+      for( auto it = idx.cbegin(); it != idx.cend() && ranking.producers.size() < MAXBPS && it->active(); ++it ) {
+         ranking.producers.push_back(producer_rank{it->owner, it->total_votes});
+         if (top_producers.size() >= MAXACTIVEBPS || it->total_votes <= 0) {
+            continue;
+         }
          top_producers.emplace_back(
                         std::pair<eosio::producer_key, uint16_t>({{it->owner, it->producer_public_key}, it->location}));
 
-         _topprods.emplace(get_self(), [&](auto &p) {
-            p.producer = it->owner;
-          });
-
-          std::vector<name>::iterator pos = std::find(prevprods.begin(), prevprods.end(), it->owner);
-          if (pos != prevprods.end()) {
-              //it was in the list before, do not ajust the resource limits, remove from list
-              prevprods.erase(pos);
+          auto pos = std::lower_bound(prevprods.begin(), prevprods.end(), it->owner);
+          if (pos != prevprods.end() && *pos == it->owner) {
+              //it was in the list before, do not ajust the resource limits
+              stillelected[pos - prevprods.begin()] = true;
           }
           else {
+              _topprods.emplace(get_self(), [&](auto &p) {
+                  p.producer = it->owner;
+              });
               //it was not in the list before, set it unlimited
               set_resource_limits(it->owner.value, -1,-1,-1);
+              prodschanged = true;
           }
       }
 
         //this is the producers exiting the schedule, reset their resoource limits.
+        bool prodsexited = false;
         for(int i=0; i < prevprods.size(); i++){
+            if (stillelected[i]) {
+                continue;
+            }
+            _topprods.erase(_topprods.find(prevprods[i].value));
+            prodsexited = true;
             //get the ram that this account has used.
             int64_t ram = get_account_ram_usage(prevprods[i].value);
             //increment the ram by the set amount.
@@ -366,6 +363,30 @@ namespace eosiosystem {
             set_resource_limits(prevprods[i].value, ram, -1, -1);
         }
 
+        //the ranking is only written when a producer or its votes changed since the last update.
+        bool rankingchanged = true;
+        if (_prodranking.exists()) {
+            const producer_ranking stored = _prodranking.get();
+            rankingchanged = stored.producers.size() != ranking.producers.size();
+            for (size_t i = 0; !rankingchanged && i < ranking.producers.size(); i++) {
+                rankingchanged = stored.producers[i].owner != ranking.producers[i].owner ||
+                                 stored.producers[i].total_votes != ranking.producers[i].total_votes;
+            }
+        }
+        if (rankingchanged) {
+            _prodranking.set(ranking, get_self());
+        }
+
+        //the bundle amount is the median of the top producer votes, recompute it when the set changes.
+        if (prodschanged || prodsexited) {
+            action(
+                    permission_level{get_self(), "active"_n},
+                    FeeContract,
+                    "updbundleamt"_n,
+                    std::make_tuple()
+            ).send();
+        }
+
       if( top_producers.size() == 0 || top_producers.size() < _gstate.last_producer_schedule_size ) {
          return;
       }
@@ -386,9 +407,15 @@ namespace eosiosystem {
       for( auto& item : top_producers )
          producers.push_back( std::move(item.first) );
 
+      //the schedule includes the producer keys, so compare the whole packed schedule with the last one proposed.
       auto packed_schedule = pack(producers);
+      const eosio::checksum256 schedule_hash = eosio::sha256(packed_schedule.data(), packed_schedule.size());
+      if (_gstate3.last_schedule_hash.has_value() && _gstate3.last_schedule_hash.value() == schedule_hash) {
+         return;
+      }
       if( set_proposed_producers(packed_schedule.data(), packed_schedule.size() ) >= 0 ) {
          _gstate.last_producer_schedule_size = static_cast<decltype(_gstate.last_producer_schedule_size)>( top_producers.size() );
+         _gstate3.last_schedule_hash.emplace(schedule_hash);
       }
     }
 
@@ -455,49 +482,41 @@ namespace eosiosystem {
         getFioAddressStruct(fio_address, fa);
         fio_400_assert(fio_address == "" || validateFioNameFormat(fa), "fio_address", fio_address, "Invalid FIO Address format",
                        ErrorDomainAlreadyRegistered);
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto domainsbyname = _domains.get_index<"byname"_n>();
         uint64_t bundleeligiblecountdown = 0;
+        uint64_t fionameid = 0;
         if (!fio_address.empty()) {
 
-          uint128_t voterHash = string_to_uint128_hash(fio_address.c_str());
-          uint128_t voterDomainHash = string_to_uint128_hash(fa.fiodomain.c_str());
-
           // compare fio_address owner and compare to actor
-          auto voter_iter = namesbyname.find(voterHash);
+          const resolved_address &voteraddress = resolve_fio_address(fio_address);
 
-          fio_400_assert(voter_iter != namesbyname.end(), "fio_address", fio_address,
+          fio_400_assert(voteraddress.found, "fio_address", fio_address,
                          "FIO address not registered", ErrorFioNameNotRegistered);
 
-          auto voterdomain_iter = domainsbyname.find(voterDomainHash);
-
-          fio_400_assert(voterdomain_iter != domainsbyname.end(), "fio_address", fio_address,
+          fio_400_assert(voteraddress.domain_found, "fio_address", fio_address,
                          "FIO Address not registered", ErrorFioNameNotReg);
-          fio_403_assert(voter_iter->owner_account == actor.value, ErrorSignature);
+          fio_403_assert(voteraddress.owner == actor.value, ErrorSignature);
 
-          uint32_t voterdomain_expiration = voterdomain_iter->expiration;
+          uint32_t voterdomain_expiration = voteraddress.domain_expiration;
           fio_400_assert(now() <= voterdomain_expiration, "fio_address", fio_address, "FIO Domain expired",
                          ErrorDomainExpired);
 
-          bundleeligiblecountdown = voter_iter->bundleeligiblecountdown;
+          bundleeligiblecountdown = voteraddress.bundleeligiblecountdown;
+          fionameid = voteraddress.fionameid;
         }
 
         for (size_t i = 0; i < producers.size(); i++) {
           getFioAddressStruct(producers[i], fa);
-          uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-          uint128_t domainHash = string_to_uint128_hash(fa.fiodomain.c_str());
+          const resolved_address &prodaddress = resolve_fio_address(fa.fioaddress);
 
-          auto fioname_iter = namesbyname.find(nameHash);
-          fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
+          fio_400_assert(prodaddress.found, "fio_address", fio_address,
                          "FIO Address not registered", ErrorFioNameNotReg);
 
-          uint64_t account = fioname_iter->owner_account;
-          auto domains_iter = domainsbyname.find(domainHash);
+          uint64_t account = prodaddress.owner;
 
-          fio_400_assert(domains_iter != domainsbyname.end(), "fio_address", fio_address,
+          fio_400_assert(prodaddress.domain_found, "fio_address", fio_address,
                          "FIO Address not registered", ErrorFioNameNotReg);
 
-          fio_400_assert(now() <= domains_iter->expiration, "domain", fa.fiodomain, "FIO Domain expired",
+          fio_400_assert(now() <= prodaddress.domain_expiration, "domain", fa.fiodomain, "FIO Domain expired",
                          ErrorDomainExpired);
 
           producers_accounts.push_back(name{account});
@@ -518,26 +537,19 @@ namespace eosiosystem {
         //note -- we can call these lock token computations like this
         //only because token locks are exclusive, meaning an account CANNOT have
         //multiple locked token grants.
-        eosio::token::computeremaininglockedtokens(actor,true);
-        eosio::token::computegenerallockedtokens(actor,true);
+        unlock_tokens(actor);
 
         sort(producers_accounts.begin(),producers_accounts.end());
 
         update_votes(actor, proxy, producers_accounts, true);
 
-        uint128_t endpoint_hash = string_to_uint128_hash(VOTE_PRODUCER_ENDPOINT);
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(VOTE_PRODUCER_ENDPOINT);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
 
         uint64_t fee_amount = 0;
 
           if (bundleeligiblecountdown > 0) {
-            action{
-                    permission_level{_self, "active"_n},
-                    AddressContract,
-                    "decrcounter"_n,
-                    make_tuple(fio_address, 1)
-            }.send();
+            charge_bundle(_self, fionameid, 1);
           } else {
             fee_amount = fee_iter->suf_amount;
             fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -585,19 +597,15 @@ namespace eosiosystem {
         fio_400_assert(fio_address == "" || validateFioNameFormat(fioAddressObj), "fio_address", fio_address, "Invalid FIO Address format",
                        ErrorDomainAlreadyRegistered);
 
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto domainsbyname = _domains.get_index<"byname"_n>();
-
         uint64_t bundleeligiblecountdown = 0;
+        uint64_t fionameid = 0;
 
-        uint128_t proxyHash = string_to_uint128_hash(proxyAddressObj.fioaddress.c_str());
-        uint128_t proxyDomainHash = string_to_uint128_hash(proxyAddressObj.fiodomain.c_str());
-        auto proxy_iter = namesbyname.find(proxyHash);
+        const resolved_address &proxyaddress = resolve_fio_address(proxyAddressObj.fioaddress);
 
-        fio_400_assert(proxy_iter != namesbyname.end(), "proxy", proxy,
+        fio_400_assert(proxyaddress.found, "proxy", proxy,
                        "FIO address not registered", ErrorFioNameNotRegistered);
 
-        uint64_t account = proxy_iter->owner_account;
+        uint64_t account = proxyaddress.owner;
 
         auto votersbyowner = _voters.get_index<"byowner"_n>();
 
@@ -612,36 +620,30 @@ namespace eosiosystem {
         fio_400_assert(voter_proxy_iter->is_proxy, "fio_address", proxy,
                        "This address is not a proxy", AddressNotProxy);
 
-        auto domains_iter = domainsbyname.find(proxyDomainHash);
-
-        fio_400_assert(domains_iter != domainsbyname.end(), "proxy", proxy,
+        fio_400_assert(proxyaddress.domain_found, "proxy", proxy,
                       "FIO Address not registered", ErrorFioNameNotReg);
 
-        fio_400_assert(now() <= get_time_plus_seconds( domains_iter->expiration, SECONDS30DAYS),
+        fio_400_assert(now() <= get_time_plus_seconds( proxyaddress.domain_expiration, SECONDS30DAYS),
                      "proxy", proxy, "FIO Domain expired", ErrorDomainExpired);
 
 
         if (!fio_address.empty()) {
-          uint128_t voterHash = string_to_uint128_hash(fioAddressObj.fioaddress.c_str());
-          uint128_t voterDomainHash = string_to_uint128_hash(fioAddressObj.fiodomain.c_str());
-
           // compare fio_address owner and compare to actor
+          const resolved_address &voteraddress = resolve_fio_address(fioAddressObj.fioaddress);
 
-          auto voter_iter = namesbyname.find(voterHash);
-
-          fio_403_assert(voter_iter->owner_account == actor.value, ErrorSignature);
-
-          fio_400_assert(voter_iter != namesbyname.end(), "fio_address", fio_address,
+          fio_400_assert(voteraddress.found, "fio_address", fio_address,
                          "FIO address not registered", ErrorFioNameNotRegistered);
 
-          auto voterdomain_iter = domainsbyname.find(voterDomainHash);
-          fio_400_assert(voterdomain_iter != domainsbyname.end(), "fio_address", fio_address,
+          fio_403_assert(voteraddress.owner == actor.value, ErrorSignature);
+
+          fio_400_assert(voteraddress.domain_found, "fio_address", fio_address,
                          "FIO Address not registered", ErrorFioNameNotReg);
 
-          fio_400_assert(now() <= voterdomain_iter->expiration, "fio_address", fio_address, "FIO Domain expired",
+          fio_400_assert(now() <= voteraddress.domain_expiration, "fio_address", fio_address, "FIO Domain expired",
                          ErrorDomainExpired);
 
-          bundleeligiblecountdown = voter_iter->bundleeligiblecountdown;
+          bundleeligiblecountdown = voteraddress.bundleeligiblecountdown;
+          fionameid = voteraddress.fionameid;
 
         }
 
@@ -661,23 +663,16 @@ namespace eosiosystem {
         //note -- we can call these lock token computations like this
         //only because token locks are exclusive, meaning an account CANNOT have
         //multiple locked token grants.
-        eosio::token::computeremaininglockedtokens(actor,true);
-        eosio::token::computegenerallockedtokens(actor,true);
+        unlock_tokens(actor);
 
         update_votes(actor, name{account}, producers, true);
 
-        uint128_t endpoint_hash = string_to_uint128_hash(VOTE_PROXY_ENDPOINT);
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(VOTE_PROXY_ENDPOINT);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
 
         uint64_t fee_amount = 0;
           if (bundleeligiblecountdown > 0) {
-            action{
-                    permission_level{_self, "active"_n},
-                    AddressContract,
-                    "decrcounter"_n,
-                      make_tuple(fio_address, 1)
-            }.send();
+            charge_bundle(_self, fionameid, 1);
         } else {
             fee_amount = fee_iter->suf_amount;
             fio_400_assert(max_fee >= (int64_t) fee_amount, "max_fee", to_string(max_fee),
@@ -724,6 +719,7 @@ namespace eosiosystem {
                 _lockedtokens.modify(lockiter, _self, [&](auto &av) {
                     av.inhibit_unlocking = value;
                 });
+                update_restriction(owner);
             }
         }
     }
@@ -734,11 +730,35 @@ namespace eosiosystem {
         //note -- we can call these lock token computations like this
         //only because token locks are exclusive, meaning an account CANNOT have
         //multiple locked token grants.
-        eosio::token::computeremaininglockedtokens(actor,true);
-        eosio::token::computegenerallockedtokens(actor,true);
+        //a summarized account has nothing to unlock before its next unlock time.
+        auto restrict_iter = _restrictions.find(actor.value);
+        if (restrict_iter != _restrictions.end()) {
+            if (now() >= restrict_iter->next_unlock) {
+                update_restriction(actor);
+            }
+        } else {
+            unlock_tokens(actor);
+        }
+    }
+
+    //perform the unlocks that are due for the owner, the votable balance of the owner is computed again afterwards.
+    void system_contract::unlock_tokens(const name &owner){
+        _votable_balances.erase(owner.value);
+        eosio::token::computeremaininglockedtokens(owner,true);
+        eosio::token::computegenerallockedtokens(owner,true);
     }
 
     uint64_t system_contract::get_votable_balance(const name &tokenowner){
+        auto cached = _votable_balances.find(tokenowner.value);
+        if (cached != _votable_balances.end()) {
+            return cached->second;
+        }
+        const uint64_t amount = compute_votable_balance(tokenowner);
+        _votable_balances[tokenowner.value] = amount;
+        return amount;
+    }
+
+    uint64_t system_contract::compute_votable_balance(const name &tokenowner){
 
         //get fio balance for this account,
         uint32_t present_time = now();
@@ -976,6 +996,7 @@ namespace eosiosystem {
         _lockedtokens.modify(iterlocked, _self, [&](auto &av) {
             av.remaining_locked_amount = amountremaining;
         });
+        update_restriction(owner);
     }
 
     void system_contract::setautoproxy(const name &proxy,const name &owner)
@@ -1036,10 +1057,7 @@ namespace eosiosystem {
                 propagate_weight_change(*itervoter);
             }
 
-            INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                    ("eosio"_n, {{_self, "active"_n}},
-                     {owner, false}
-                    );
+            queue_power_update(owner, false, _self);
         }
     }
 
@@ -1052,37 +1070,29 @@ namespace eosiosystem {
         getFioAddressStruct(fio_address, fa);
 
 
-        uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-        uint128_t domainHash = string_to_uint128_hash(fa.fiodomain.c_str());
+        const resolved_address &address = resolve_fio_address(fa.fioaddress);
 
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto fioname_iter = namesbyname.find(nameHash);
-
-        fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint64_t account = fioname_iter->owner_account;
+        uint64_t account = address.owner;
         fio_403_assert(account == actor.value, ErrorSignature);
 
-        auto domainsbyname = _domains.get_index<"byname"_n>();
-        auto domains_iter = domainsbyname.find(domainHash);
-
-        fio_400_assert(domains_iter != domainsbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.domain_found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint32_t expiration = domains_iter->expiration;
+        uint32_t expiration = address.domain_expiration;
         fio_400_assert(now() <= expiration, "domain", fa.fiodomain, "FIO Domain expired",
                        ErrorDomainExpired);
 
         regiproxy(actor,fio_address,false);
 
         //begin new fees, logic for Mandatory fees.
-        uint128_t endpoint_hash = string_to_uint128_hash(UNREGISTER_PROXY_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(UNREGISTER_PROXY_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
         //if the fee isnt found for the endpoint, then 400 error.
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", UNREGISTER_PROXY_ENDPOINT,
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", UNREGISTER_PROXY_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -1123,24 +1133,17 @@ namespace eosiosystem {
         FioAddress fa;
         getFioAddressStruct(fio_address, fa);
 
-        uint128_t nameHash = string_to_uint128_hash(fa.fioaddress.c_str());
-        uint128_t domainHash = string_to_uint128_hash(fa.fiodomain.c_str());
-
-        auto namesbyname = _fionames.get_index<"byname"_n>();
-        auto fioname_iter = namesbyname.find(nameHash);
-        fio_400_assert(fioname_iter != namesbyname.end(), "fio_address", fio_address,
+        const resolved_address &address = resolve_fio_address(fa.fioaddress);
+        fio_400_assert(address.found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint64_t account = fioname_iter->owner_account;
+        uint64_t account = address.owner;
         fio_403_assert(account == actor.value, ErrorSignature);
 
-        auto domainsbyname = _domains.get_index<"byname"_n>();
-        auto domains_iter = domainsbyname.find(domainHash);
-
-        fio_400_assert(domains_iter != domainsbyname.end(), "fio_address", fio_address,
+        fio_400_assert(address.domain_found, "fio_address", fio_address,
                        "FIO Address not registered", ErrorFioNameNotReg);
 
-        uint32_t expiration = domains_iter->expiration;
+        uint32_t expiration = address.domain_expiration;
 
         //add 30 days to the domain expiration, this call will work until 30 days past expire.
         expiration = get_time_plus_seconds(expiration,SECONDS30DAYS);
@@ -1151,12 +1154,11 @@ namespace eosiosystem {
         regiproxy(actor,fio_address,true);
 
         //begin new fees, logic for Mandatory fees.
-        uint128_t endpoint_hash = string_to_uint128_hash(REGISTER_PROXY_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(REGISTER_PROXY_ENDPOINT);
 
-        auto fees_by_endpoint = _fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(_fiofees, endpoint_fee);
         //if the fee isnt found for the endpoint, then 400 error.
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", REGISTER_PROXY_ENDPOINT,
+        fio_400_assert(fee_iter != _fiofees.end(), "endpoint_name", REGISTER_PROXY_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -1178,10 +1180,7 @@ namespace eosiosystem {
         processrewardsnotpid(reg_amount, get_self());
         //end new fees, logic for Mandatory fees.
 
-        INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                ("eosio"_n, {{_self, "active"_n}},
-                 {actor, false}
-                );
+        queue_power_update(actor, false, _self);
 
         _audit_global_info.audit_reset = true;
 
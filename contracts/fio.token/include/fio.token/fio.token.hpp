@@ -58,6 +58,7 @@ namespace eosio {
 
     class [[eosio::contract("fio.token")]] token : public contract {
     private:
+        fioio::power_update_sender power_updates;
         fioio::eosio_names_table eosionames;
         fioio::fiofee_table fiofees;
         fioio::config appConfig;
@@ -205,10 +206,32 @@ namespace eosio {
         //This action will compute the number of unlocked tokens contained within an account.
         // This considers
         static uint64_t computeusablebalance(const name &owner,bool updatelocks, bool isfee){
-            uint64_t genesislockedamount = computeremaininglockedtokens(owner,updatelocks);
-            uint64_t generallockedamount = computegenerallockedtokens(owner,updatelocks);
+            uint64_t genesislockedamount = 0;
+            uint64_t generallockedamount = 0;
             uint64_t stakedfio = 0;
 
+            //use the restriction summary when it is current, accounts without a summary hold no locks
+            //once the summary migration is finished. otherwise compute the locks.
+            bool summarized = false;
+            if (!updatelocks) {
+                eosiosystem::account_restrictions_table restrictions(SYSTEMACCOUNT, SYSTEMACCOUNT.value);
+                auto restrict_iter = restrictions.find(owner.value);
+                if (restrict_iter != restrictions.end()) {
+                    if (now() < restrict_iter->next_unlock) {
+                        genesislockedamount = restrict_iter->genesis_locked;
+                        generallockedamount = restrict_iter->general_locked;
+                        summarized = true;
+                    }
+                } else {
+                    eosiosystem::restriction_migration_singleton restrictmigr(SYSTEMACCOUNT, SYSTEMACCOUNT.value);
+                    summarized = restrictmigr.exists() && restrictmigr.get().finished;
+                }
+            }
+            if (!summarized) {
+                genesislockedamount = computeremaininglockedtokens(owner,updatelocks);
+                generallockedamount = computegenerallockedtokens(owner,updatelocks);
+            }
+
             fioio::account_staking_table accountstaking(STAKINGACCOUNT, STAKINGACCOUNT.value);
             auto astakebyaccount = accountstaking.get_index<"byaccount"_n>();
             auto astakeiter = astakebyaccount.find(owner.value);
@@ -217,12 +240,22 @@ namespace eosio {
                 stakedfio = astakeiter->total_staked_fio;
             }
 
+            const auto my_balance = eosio::token::get_balance("fio.token"_n, owner, FIOSYMBOL.code());
+            //the summary is not updated when the locks are removed as incoherent (BD-4643), so
+            //compute the locks when the summarized amounts do not fit in the balance. every other change
+            //of the locks updates the summary and the check below keeps the balance at or above the locked
+            //plus staked amount, so only those accounts compute again. the staked amount is not summarized,
+            //it is read from fio.staking each time as before.
+            if (summarized && my_balance.amount < generallockedamount + stakedfio + (isfee ? 0 : genesislockedamount)) {
+                genesislockedamount = computeremaininglockedtokens(owner,updatelocks);
+                generallockedamount = computegenerallockedtokens(owner,updatelocks);
+            }
+
             uint64_t bamount = generallockedamount + stakedfio;
             if (!isfee){
                 bamount += genesislockedamount;
             }
             //apply a little QC.
-            const auto my_balance = eosio::token::get_balance("fio.token"_n, owner, FIOSYMBOL.code());
             check(my_balance.amount >= bamount,
                          "computeusablebalance, amount of locked fio plus staked is greater than balance!! for " + owner.to_string() );
             uint64_t amount = 0;
@@ -444,6 +477,17 @@ namespace eosio {
             if (lockiter != locks_by_owner.end()) {
                 //if the lock is not already completely paid out.
                 if (lockiter->payouts_performed < lockiter->periods.size()) {
+                    //before next_unlock the lock is coherent and has nothing to unlock, only the
+                    //BD-4643 balance check applies.
+                    if (present_time < lockiter->next_unlock.value_or(0)) {
+                        const auto my_balance = eosio::token::get_balance("fio.token"_n, actor, FIOSYMBOL.code());
+                        uint64_t amount = my_balance.amount;
+                        if (lockiter->remaining_lock_amount > amount) {
+                            locks_by_owner.erase(lockiter);
+                            return 0;
+                        }
+                        return lockiter->remaining_lock_amount;
+                    }
                     uint32_t secondsSinceGrant = (present_time - lockiter->timestamp);
                     uint32_t number_unlocks = 0;  //this is the number of unlock periods to perform at this time.
                     uint64_t computed_amount_unlock = 0; // this is the computed amount of fio to unlock at this time.
@@ -519,6 +563,7 @@ namespace eosio {
                         locks_by_owner.modify(lockiter, SYSTEMACCOUNT, [&](auto &av) {
                             av.remaining_lock_amount = use_remaining_lock_amount;
                             av.payouts_performed = number_unlocks;
+                            av.set_unlock_times(present_time);
                         });
                     }
 
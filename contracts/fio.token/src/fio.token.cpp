@@ -129,10 +129,7 @@ namespace eosio {
           s.supply.amount -= quantity;
         });
 
-        INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-            ("eosio"_n, {{_self, "active"_n}},
-              {actor, true}
-            );
+        queue_power_update(actor, true, _self);
 
         const string response_string = string("{\"status\": \"OK\"}");
 
@@ -253,12 +250,11 @@ namespace eosio {
         fio_400_assert(max_fee >= 0, "max_fee", to_string(max_fee), "Invalid fee value.",
                        ErrorMaxFeeInvalid);
 
-        uint128_t endpoint_hash = fioio::string_to_uint128_hash(TRANSFER_TOKENS_PUBKEY_ENDPOINT);
+        constexpr fee_endpoint endpoint_fee = builtin_fee(TRANSFER_TOKENS_PUBKEY_ENDPOINT);
 
-        auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", TRANSFER_TOKENS_PUBKEY_ENDPOINT,
+        fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", TRANSFER_TOKENS_PUBKEY_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -403,16 +399,10 @@ namespace eosio {
         sub_balance(actor, qty);
         add_balance(new_account_name, qty, actor);
 
-        INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                ("eosio"_n, {{_self, "active"_n}},
-                 {actor, true}
-                );
+        queue_power_update(actor, true, _self);
 
         if (accountExists && updatepowerowner) {
-            INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                    ("eosio"_n, {{_self, "active"_n}},
-                     {new_account_name, true}
-                    );
+            queue_power_update(new_account_name, true, _self);
         }
 
 
@@ -542,12 +532,11 @@ namespace eosio {
                              const name &actor,
                              const string &tpid) {
 
-       uint128_t endpoint_hash = fioio::string_to_uint128_hash("transfer_tokens_pub_key");
+       constexpr fee_endpoint endpoint_fee = builtin_fee(TRANSFER_TOKENS_PUBKEY_ENDPOINT);
 
-       auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-       auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+       auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-       fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", "transfer_tokens_pub_key",
+       fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", TRANSFER_TOKENS_PUBKEY_ENDPOINT,
                       "FIO fee not found for endpoint", ErrorNoEndpoint);
 
        uint64_t reg_amount = fee_iter->suf_amount;
@@ -694,12 +683,11 @@ namespace eosio {
         fio_400_assert(((can_vote == 0)||(can_vote == 1)), "can_vote", to_string(can_vote),
                        "Invalid can_vote value", ErrorInvalidValue);
 
-        uint128_t endpoint_hash = fioio::string_to_uint128_hash("transfer_locked_tokens");
+        constexpr fee_endpoint endpoint_fee = builtin_fee(TRANSFER_LOCKED_TOKENS_ENDPOINT);
 
-        auto fees_by_endpoint = fiofees.get_index<"byendpoint"_n>();
-        auto fee_iter = fees_by_endpoint.find(endpoint_hash);
+        auto fee_iter = find_fee(fiofees, endpoint_fee);
 
-        fio_400_assert(fee_iter != fees_by_endpoint.end(), "endpoint_name", "transfer_locked_tokens",
+        fio_400_assert(fee_iter != fiofees.end(), "endpoint_name", TRANSFER_LOCKED_TOKENS_ENDPOINT,
                        "FIO fee not found for endpoint", ErrorNoEndpoint);
 
         uint64_t reg_amount = fee_iter->suf_amount;
@@ -764,10 +752,7 @@ namespace eosio {
         }
         // end FIP-41 logic for send lock tokens to existing account
         //because we adapt locks do one more voting power calc here.
-        INLINE_ACTION_SENDER(eosiosystem::system_contract, updatepower)
-                    ("eosio"_n, {{_self, "active"_n}},
-                     {owner, true}
-                    );
+        queue_power_update(owner, true, _self);
 
         int64_t raminc = 1200;
 
@@ -14,8 +14,11 @@ class [[eosio::contract("TPIDController")]]  TPIDController: public eosio::contr
 
 private:
         tpids_table tpids;
+        payabletpids_table payabletpids;
+        payablemigr_singleton payablemigrs;
         fionames_table fionames;
         eosiosystem::voters_table voters;
+        eosiosystem::producers_table producers;
         bounties_table bounties;
         bool debugout = false;
 
@@ -24,8 +27,18 @@ public:
 
         TPIDController(name s, name code, datastream<const char *> ds) :
                 contract(s, code, ds), tpids(_self, _self.value), bounties(_self, _self.value),
+                payabletpids(_self, _self.value), payablemigrs(_self, _self.value),
                 fionames(AddressContract, AddressContract.value),
-                voters(AddressContract, AddressContract.value) {
+                voters(AddressContract, AddressContract.value),
+                producers(SYSTEMACCOUNT, SYSTEMACCOUNT.value) {
+        }
+
+        inline void queue_payable(const uint64_t &id) {
+                if (payabletpids.find(id) == payabletpids.end()) {
+                        payabletpids.emplace(get_self(), [&](struct payabletpid &p) {
+                                p.id = id;
+                        });
+                }
         }
 
         // this action will perform the logic of checking the voter_info,
@@ -87,17 +100,7 @@ public:
                 }
         }
 
-        //Condition: check if tpid exists in fionames before executing.
-        //This call should only be made by processrewards and processbucketrewards in fio.rewards.hpp
-        //which should also only be called by contracts that collect fees
-        //@abi action
-        [[eosio::action]]
-        void updatetpid(const string &tpid, const name owner, const uint64_t &amount) {
-
-                eosio_assert(has_auth(AddressContract) || has_auth(TokenContract) || has_auth(TREASURYACCOUNT)
-                || has_auth(FIOORACLEContract) || has_auth(STAKINGACCOUNT) ||   has_auth("fio.reqobt"_n)
-                || has_auth("eosio"_n) || has_auth(EscrowContract) || has_auth(PERMSACCOUNT),
-                             "missing required authority of fio.address, fio.treasury, fio.token, eosio or fio.reqobt fio.perms or fio.staking");
+        inline void credit_tpid(const string &tpid, const name &owner, const uint64_t &amount) {
             if (debugout) {
                 print("update tpid calling updatetpid with tpid ", tpid, " owner ", owner, "\n");
             }
@@ -116,12 +119,47 @@ public:
                 }
                 process_auto_proxy(tpid, owner);
                 //Update existing tpid amount or amount of tpid that was just created before
-                tpidsbyname.modify(tpidsbyname.find(tpidhash), get_self(), [&](struct tpid &f) {
+                auto tpid_iter = tpidsbyname.find(tpidhash);
+                tpidsbyname.modify(tpid_iter, get_self(), [&](struct tpid &f) {
                                 f.rewards += amount;
                         });
+                if (tpid_iter->rewards >= REWARDMAX) {
+                        queue_payable(tpid_iter->id);
+                }
+
+        }
+
+        //Condition: check if tpid exists in fionames before executing.
+        //This call should only be made by processrewards and processbucketrewards in fio.rewards.hpp
+        //which should also only be called by contracts that collect fees
+        //@abi action
+        [[eosio::action]]
+        void updatetpid(const string &tpid, const name owner, const uint64_t &amount) {
 
+                eosio_assert(has_auth(AddressContract) || has_auth(TokenContract) || has_auth(TREASURYACCOUNT)
+                || has_auth(FIOORACLEContract) || has_auth(STAKINGACCOUNT) ||   has_auth("fio.reqobt"_n)
+                || has_auth("eosio"_n) || has_auth(EscrowContract) || has_auth(PERMSACCOUNT),
+                             "missing required authority of fio.address, fio.treasury, fio.token, eosio or fio.reqobt fio.perms or fio.staking");
+                credit_tpid(tpid, owner, amount);
         } //updatetpid
 
+        //Combines updatetpid and updatebounty so a fee with a tpid sends one action to fio.tpid.
+        //The bounty may only be recorded with the authority of fio.treasury, which mints it.
+        //This call should only be made by processrewards and processbucketrewards in fio.common.hpp
+        //@abi action
+        [[eosio::action]]
+        void rewardtpid(const string &tpid, const name owner, const uint64_t &amount, const uint64_t &bountyamount) {
+                eosio_assert(has_auth(AddressContract) || has_auth(TokenContract) || has_auth(TREASURYACCOUNT)
+                || has_auth(FIOORACLEContract) || has_auth(STAKINGACCOUNT) ||   has_auth("fio.reqobt"_n)
+                || has_auth("eosio"_n) || has_auth(EscrowContract) || has_auth(PERMSACCOUNT),
+                             "missing required authority of fio.address, fio.treasury, fio.token, eosio or fio.reqobt fio.perms or fio.staking");
+                if (bountyamount > 0) {
+                        require_auth(TREASURYACCOUNT);
+                        bounties.set(bounties.exists() ? bounty{bounties.get().tokensminted + bountyamount} : bounty{bountyamount}, _self);
+                }
+                credit_tpid(tpid, owner, amount);
+        }
+
         //This action can only be called by fio.treasury after successful rewards payment to tpid
         //@abi action
         [[eosio::action]]
@@ -134,9 +172,46 @@ public:
                         tpidsbyname.modify(tpidfound, _self, [&](struct tpid &f) {
                                         f.rewards = 0;
                                 });
+                        auto payable_iter = payabletpids.find(tpidfound->id);
+                        if (payable_iter != payabletpids.end()) {
+                                payabletpids.erase(payable_iter);
+                        }
                 }
         }
 
+        //This action adds the tpids that reached REWARDMAX before payabletpids existed to payabletpids,
+        //up to 100 tpids are checked per call in id order. tpidclaim uses payabletpids once this is finished.
+        //@abi action
+        [[eosio::action]]
+        void migrpayable(const uint16_t &amount, const name &actor) {
+                require_auth(actor);
+
+                auto prodbyowner = producers.get_index<"byowner"_n>();
+                fio_400_assert(prodbyowner.find(actor.value) != prodbyowner.end(), "actor", actor.to_string(),
+                               "Actor not active producer", ErrorNoFioAddressProducer);
+
+                payablemigr migr = payablemigrs.get_or_default();
+                fio_400_assert(!migr.finished, "migrpayable", "migrpayable", "No Work.", ErrorNoWork);
+
+                const uint16_t limit = amount > 100 ? 100 : amount;
+                uint16_t count = 0;
+                auto tpid_iter = tpids.lower_bound(migr.next_id);
+                while (tpid_iter != tpids.end() && count < limit) {
+                        if (tpid_iter->rewards >= REWARDMAX) {
+                                queue_payable(tpid_iter->id);
+                        }
+                        migr.next_id = tpid_iter->id + 1;
+                        count++;
+                        tpid_iter++;
+                }
+                migr.finished = tpid_iter == tpids.end();
+                payablemigrs.set(migr, _self);
+
+                const string response_string = string("{\"status\": \"OK\",\"tpids_checked\":") +
+                                               to_string(count) + string("}");
+                send_response(response_string.c_str());
+        }
+
         //Must be called at least once at genesis for tokensminted check in fio.rewards.hpp
         //@abi action
         [[eosio::action]]
@@ -147,6 +222,6 @@ public:
         }
 };     //class TPIDController
 
-EOSIO_DISPATCH(TPIDController, (updatetpid)(rewardspaid)
-               (updatebounty))
+EOSIO_DISPATCH(TPIDController, (updatetpid)(rewardtpid)(rewardspaid)
+               (updatebounty)(migrpayable))
 }
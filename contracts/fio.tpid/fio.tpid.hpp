@@ -14,6 +14,8 @@
 #include <eosiolib/eosio.hpp>
 #include <eosiolib/asset.hpp>
 
+#define REWARDMAX       100000000000            // 100 FIO
+
 namespace fioio {
     using namespace eosio;
 
@@ -35,4 +37,32 @@ namespace fioio {
     typedef multi_index<"tpids"_n, tpid,
             indexed_by<"byname"_n, const_mem_fun < tpid, uint128_t, &tpid::by_name>>>
     tpids_table;
+
+    // this table holds the ids of the tpids whose rewards have reached REWARDMAX, it is maintained by
+    // updatetpid and rewardspaid so tpidclaim visits only payable tpids, in tpid id order.
+    // fio.address removes the row when it erases a tpid in burnexpired or burnaddress.
+    // @abi table payabletpids i64
+    struct [[eosio::action]] payabletpid {
+
+        uint64_t id;
+
+        uint64_t primary_key() const { return id; }
+
+        EOSLIB_SERIALIZE(payabletpid, (id)
+        )
+    };
+
+    typedef multi_index<"payabletpids"_n, payabletpid> payabletpids_table;
+
+    // progress of loading the tpids that were payable before payabletpids existed,
+    // next_id is the next tpid id to check.
+    struct [[eosio::action]] payablemigr {
+        uint64_t next_id = 0;
+        bool finished = false;
+
+        EOSLIB_SERIALIZE(payablemigr, (next_id)(finished)
+        )
+    };
+
+    typedef singleton<"payablemigr"_n, payablemigr> payablemigr_singleton;
 }
@@ -6,7 +6,6 @@
  *  @license FIO Foundation ( https://github.com/fioprotocol/fio/blob/master/LICENSE ) Dapix
  */
 
-#define REWARDMAX       100000000000            // 100 FIO
 #define FDTNMAXTOMINT   150000000000000         // 150,000 FIO
 #define BPMAXTOMINT     50000000000000          // 50,000  FIO
 #define FDTNMAXRESERVE  181253654000000000      // 181,253,654 FIO
@@ -22,13 +21,17 @@ namespace fioio {
 class [[eosio::contract("FIOTreasury")]]  FIOTreasury: public eosio::contract {
 
 private:
+        power_update_sender power_updates;
         tpids_table tpids;
+        payabletpids_table payabletpids;
+        payablemigr_singleton payablemigrs;
         fionames_table fionames;
         domains_table domains;
         rewards_table clockstate;
         bprewards_table bprewards;
         bpbucketpool_table bucketrewards;
         fdtnrewards_table fdtnrewards;
+        rewardaccum_table rewardaccums;
         voteshares_table voteshares;
         eosiosystem::eosio_global_state gstate;
         eosiosystem::global_state_singleton global;
@@ -42,6 +45,8 @@ public:
         using contract::contract;
         FIOTreasury(name s, name code, datastream<const char *> ds) : contract(s, code, ds),
                 tpids(TPIDContract, TPIDContract.value),
+                payabletpids(TPIDContract, TPIDContract.value),
+                payablemigrs(TPIDContract, TPIDContract.value),
                 fionames(AddressContract, AddressContract.value),
                 domains(AddressContract, AddressContract.value),
                 bprewards(get_self(), get_self().value),
@@ -51,17 +56,69 @@ public:
                 global(SYSTEMACCOUNT, SYSTEMACCOUNT.value),
                 fdtnrewards(get_self(), get_self().value),
                 bucketrewards(get_self(), get_self().value),
+                rewardaccums(get_self(), get_self().value),
                 staking(STAKINGACCOUNT, STAKINGACCOUNT.value){
                   state = clockstate.get_or_default();
         }
 
 
 
+        //fold the accrued fee rewards into the bprewards, bpbucketpool and fdtnrewards singletons and
+        //mint the accrued tpid bounties to the treasury. returns false when there is nothing to settle.
+        bool settle_rewards() {
+                if (!rewardaccums.exists()) return false;
+                const rewardaccum accrued = rewardaccums.get();
+                if (accrued.bprewards == 0 && accrued.bppool == 0 && accrued.fdtnrewards == 0 &&
+                    accrued.bounty == 0) return false;
+
+                if (accrued.bprewards > 0) {
+                        bprewards.set(bprewards.exists() ? bpreward{bprewards.get().rewards + accrued.bprewards} : bpreward{accrued.bprewards}, get_self());
+                }
+                if (accrued.bppool > 0) {
+                        bucketrewards.set(bucketrewards.exists() ? bucketpool{bucketrewards.get().rewards + accrued.bppool} : bucketpool{accrued.bppool}, get_self());
+                }
+                if (accrued.fdtnrewards > 0) {
+                        fdtnrewards.set(fdtnrewards.exists() ? fdtnreward{fdtnrewards.get().rewards + accrued.fdtnrewards} : fdtnreward{accrued.fdtnrewards}, get_self());
+                }
+                if (accrued.bounty > 0) {
+                        action(permission_level{get_self(), "active"_n},
+                               TokenContract, "mintfio"_n,
+                               make_tuple(TREASURYACCOUNT, accrued.bounty)
+                        ).send();
+                }
+                rewardaccums.set(rewardaccum{}, get_self());
+                return true;
+        }
+
         //FIOTreasury deconstructor sets the clockstate
         ~FIOTreasury() {
           clockstate.set(state, get_self());
         }
 
+        //pay the rewards of a tpid to the owner of its fio address, or to the bp rewards if the
+        //fio address has been burned.
+        void pay_tpid(const tpid &itr) {
+                auto namesbyname = fionames.get_index<"byname"_n>();
+                auto itrfio = namesbyname.find(string_to_uint128_hash(itr.fioaddress.c_str()));
+
+                // If the fioaddress exists (address could have been burned)
+                if (itrfio != namesbyname.end()) {
+                        action(permission_level{get_self(), "active"_n},
+                               TokenContract, "transfer"_n,
+                               make_tuple(TREASURYACCOUNT, name(itrfio->owner_account),
+                                          asset(itr.rewards, FIOSYMBOL),
+                                          string("Paying TPID from treasury."))
+                        ).send();
+                        queue_power_update(name(itrfio->owner_account), true, get_self());
+                } else { //Allocate to BP buckets instead
+                        bprewards.set(bpreward{bprewards.get().rewards + itr.rewards}, get_self());
+                }
+                action(permission_level{get_self(), "active"_n},
+                       "fio.tpid"_n, "rewardspaid"_n,
+                       make_tuple(itr.fioaddress)
+                ).send();
+        }
+
         // @abi action
         [[eosio::action]]
         void tpidclaim(const name &actor) {
@@ -69,39 +126,32 @@ public:
 
                 uint64_t tpids_paid = 0;
 
+                //the tpid rewards are paid from the treasury balance, the accrued bounties are minted first.
+                settle_rewards();
+
                 //This contract should only be able to iterate throughout the entire tpids table to
                 //to check for rewards once every x blocks.
                 fio_400_assert(now() > state.lasttpidpayout + MINUTE, "tpidclaim", "tpidclaim",
                                 "No work.", ErrorNoWork);
 
-                for (const auto &itr : tpids) {
-                        if (itr.rewards >= REWARDMAX) { //100 FIO (100,000,000,000 SUF)
-                                auto namesbyname = fionames.get_index<"byname"_n>();
-                                auto itrfio = namesbyname.find(string_to_uint128_hash(itr.fioaddress.c_str()));
-
-                                // If the fioaddress exists (address could have been burned)
-                                if (itrfio != namesbyname.end()) {
-                                        action(permission_level{get_self(), "active"_n},
-                                               TokenContract, "transfer"_n,
-                                               make_tuple(TREASURYACCOUNT, name(itrfio->owner_account),
-                                                          asset(itr.rewards, FIOSYMBOL),
-                                                          string("Paying TPID from treasury."))
-                                        ).send();
-                                        action(permission_level{get_self(), "active"_n},
-                                               SYSTEMACCOUNT, "updatepower"_n,
-                                               make_tuple(name(itrfio->owner_account), true)
-                                        ).send();
-                                } else { //Allocate to BP buckets instead
-                                        bprewards.set(bpreward{bprewards.get().rewards + itr.rewards}, get_self());
-                                }
-                                action(permission_level{get_self(), "active"_n},
-                                       "fio.tpid"_n, "rewardspaid"_n,
-                                       make_tuple(itr.fioaddress)
-                                ).send();
+                //once fio.tpid has loaded the previously payable tpids, only the payable tpids are visited.
+                if (payablemigrs.exists() && payablemigrs.get().finished) {
+                        for (const auto &payable : payabletpids) {
+                                auto tpid_iter = tpids.find(payable.id);
+                                if (tpid_iter == tpids.end() || tpid_iter->rewards < REWARDMAX) continue;
+                                pay_tpid(*tpid_iter);
                                 tpids_paid++;
                                 if (tpids_paid >= PAYABLETPIDS) break; //only paying 100 tpids
-                        } // endif itr.rewards >=
-                } // for (const auto &itr : tpids)
+                        }
+                } else {
+                        for (const auto &itr : tpids) {
+                                if (itr.rewards >= REWARDMAX) { //100 FIO (100,000,000,000 SUF)
+                                        pay_tpid(itr);
+                                        tpids_paid++;
+                                        if (tpids_paid >= PAYABLETPIDS) break; //only paying 100 tpids
+                                } // endif itr.rewards >=
+                        } // for (const auto &itr : tpids)
+                }
 
                 fio_400_assert(tpids_paid > 0, "tpidclaim", "tpidclaim","No work.", ErrorNoWork);
 
@@ -128,14 +178,8 @@ public:
                 asset(amount, FIOSYMBOL),
                 string("Paying Staking Rewards"))
             ).send();
-            action(permission_level{get_self(), "active"_n},
-                   SYSTEMACCOUNT, "updatepower"_n,
-                   make_tuple(name(actor), true)
-            ).send();
-            action(permission_level{get_self(), "active"_n},
-                   SYSTEMACCOUNT, "updatepower"_n,
-                   make_tuple(TREASURYACCOUNT, true)
-            ).send();
+            queue_power_update(name(actor), true, get_self());
+            queue_power_update(TREASURYACCOUNT, true, get_self());
 
         }
 
@@ -145,6 +189,9 @@ public:
         void bpclaim(const string &fio_address, const name &actor) {
                 require_auth(actor);
 
+                //the pay schedule and foundation payout must see every fee collected so far.
+                settle_rewards();
+
                 gstate = global.get();
                 check( gstate.total_voted_fio >= MINVOTEDFIO || gstate.thresh_voted_fio_time != time_point() ,
                        "cannot claim rewards until the chain voting threshold is exceeded" );
@@ -185,7 +232,7 @@ public:
                 //if it has been 24 hours, transfer remaining producer vote_shares to the foundation and record the rewards back into bprewards,
                 // then erase the pay schedule so a new one can be created in a subsequent call to bpclaim.
                 if (clockstate.exists() && now() >= state.payschedtimer + PAYSCHEDTIME) { //+ 172801
-                        if (std::distance(voteshares.begin(), voteshares.end()) > 0) {
+                        if (voteshares.begin() != voteshares.end()) {
                                 auto iter = voteshares.begin();
                                 while (iter != voteshares.end()) {
                                         iter = voteshares.erase(iter);
@@ -195,7 +242,7 @@ public:
 
                 //*********** CREATE PAYSCHEDULE **************
                 // If there is no pay schedule then create a new one
-                if (std::distance(voteshares.begin(), voteshares.end()) == 0) { //if new payschedule
+                if (voteshares.begin() == voteshares.end()) { //if new payschedule
 
                     //process the staking rewards, once per day.
                     /*
@@ -237,26 +284,38 @@ public:
                     //Create the payment schedule
                     int64_t bpcounter = 0;
                     uint64_t activecount = 0;
-                    //prototal votes returns active producers sorted beginning at the highest voted to the lowest voted
-                    // active producers  then for inactive producers lowest voted to highest voted.
-                    auto proditer = producers.get_index<"prototalvote"_n>();
-                    auto itr = proditer.begin();
-
-                    int32_t prodcount = std::distance(producers.begin(), producers.end());
-                    check(prodcount > 0,"error -- no producers");
-
-                    for (int32_t idx=0;idx < prodcount; idx++) {
-                        if (itr->is_active) {
+                    //use the ranking of the active producers kept by fio.system when it exists. the ranking is
+                    //taken at the last producer schedule update, so each producer is checked to still be active.
+                    eosiosystem::producer_ranking_singleton prodranking(SYSTEMACCOUNT, SYSTEMACCOUNT.value);
+                    if (prodranking.exists()) {
+                        const auto ranking = prodranking.get();
+                        auto rankbyowner = producers.get_index<"byowner"_n>();
+                        for (const auto &rank : ranking.producers) {
+                            auto prod_iter = rankbyowner.find(rank.owner.value);
+                            if (prod_iter == rankbyowner.end() || !prod_iter->is_active) continue;
                             voteshares.emplace(actor, [&](auto &p) {
-                                p.owner = itr->owner;
-                                p.votes = itr->total_votes;
+                                p.owner = prod_iter->owner;
+                                p.votes = prod_iter->total_votes;
                             });
                             bpcounter++;
+                            if (bpcounter >= MAXBPS) break;
                         }
-
-                        itr++;
-                        if (bpcounter >= MAXBPS) break;
-                    } // &itr : producers table
+                    } else {
+                        //prototal votes returns active producers sorted beginning at the highest voted to the lowest voted
+                        // active producers  then for inactive producers lowest voted to highest voted.
+                        auto proditer = producers.get_index<"prototalvote"_n>();
+                        check(proditer.begin() != proditer.end(),"error -- no producers");
+
+                        for (auto itr = proditer.begin(); itr != proditer.end() && bpcounter < MAXBPS; itr++) {
+                            if (itr->is_active) {
+                                voteshares.emplace(actor, [&](auto &p) {
+                                    p.owner = itr->owner;
+                                    p.votes = itr->total_votes;
+                                });
+                                bpcounter++;
+                            }
+                        } // &itr : producers table
+                    }
                     //Move 1/365 of the bucketpool to the bpshare
                         bprewards.set(bpreward{bprewards.get().rewards + static_cast<uint64_t>(bucketrewards.get().rewards / YEARDAYS)}, get_self());
                         bucketrewards.set(bucketpool{bucketrewards.get().rewards - static_cast<uint64_t>(bucketrewards.get().rewards / YEARDAYS)}, get_self());
@@ -308,7 +367,8 @@ public:
 
                         }
                         // All bps are now in pay schedule, calculate the shares
-                        int64_t bpcount = std::distance(voteshares.begin(), voteshares.end());
+                        //the pay schedule was empty, it holds the producers counted above.
+                        int64_t bpcount = bpcounter;
                         int64_t abpcount = MAXACTIVEBPS;
 
                         if (bpcount <= MAXACTIVEBPS) abpcount = bpcount;
@@ -357,14 +417,8 @@ public:
                                        make_tuple(TREASURYACCOUNT, name(bpiter->owner), asset(payout, FIOSYMBOL),
                                                   string("Paying producer from treasury."))
                                        ).send();
-                                action(permission_level{get_self(), "active"_n},
-                                       SYSTEMACCOUNT, "updatepower"_n,
-                                       make_tuple(name(bpiter->owner), true)
-                                ).send();
-                                action(permission_level{get_self(), "active"_n},
-                                       SYSTEMACCOUNT, "updatepower"_n,
-                                       make_tuple(TREASURYACCOUNT, true)
-                                ).send();
+                                queue_power_update(name(bpiter->owner), true, get_self());
+                                queue_power_update(TREASURYACCOUNT, true, get_self());
 
                                 // Reduce the producer's share of daily rewards and bucketrewards
                                 if (bpiter->abpayshare > 0) {
@@ -388,14 +442,8 @@ public:
                                    make_tuple(TREASURYACCOUNT, FOUNDATIONACCOUNT, asset(fdtnstate.rewards, FIOSYMBOL),
                                               string("Paying foundation from treasury."))).send();
                             //foundation account does not vote, so no updatepower here.
-                            action(permission_level{get_self(), "active"_n},
-                                   SYSTEMACCOUNT, "updatepower"_n,
-                                   make_tuple(FOUNDATIONACCOUNT, true)
-                            ).send();
-                            action(permission_level{get_self(), "active"_n},
-                                   SYSTEMACCOUNT, "updatepower"_n,
-                                   make_tuple(TREASURYACCOUNT, true)
-                            ).send();
+                            queue_power_update(FOUNDATIONACCOUNT, true, get_self());
+                            queue_power_update(TREASURYACCOUNT, true, get_self());
                         }
 
                         //Clear the foundation rewards counter
@@ -444,6 +492,54 @@ public:
                 bucketrewards.set(bucketrewards.exists() ? bucketpool{bucketrewards.get().rewards + amount} : bucketpool{amount}, get_self());
         }
 
+        //this action accrues the block producer, bucket pool and foundation shares of a fee and the tpid
+        //bounty to mint, they are applied by settlerwds or the next bpclaim or tpidclaim, which pay from them.
+        //each share may only be accrued by the accounts allowed to call the action it replaces,
+        //bprewdupdate, bppoolupdate, fdtnrwdupdat and mintfio.
+        // @abi action
+        [[eosio::action]]
+        void accrrewards(const uint64_t &bpamount, const uint64_t &bppoolamount, const uint64_t &fdtnamount,
+                         const uint64_t &bountyamount) {
+                if (bpamount > 0) {
+                        eosio_assert((has_auth(AddressContract) || has_auth(TokenContract) || has_auth(TREASURYACCOUNT) ||
+                                     has_auth(STAKINGACCOUNT) ||  has_auth(REQOBTACCOUNT) || has_auth(SYSTEMACCOUNT) || has_auth(FeeContract) || has_auth(FIOORACLEContract)),
+                                     "missing required authority of fio.address, fio.treasury, fio.fee, fio.token, fio.staking, fio.oracle, eosio or fio.reqobt");
+                }
+                if (bppoolamount > 0) {
+                        eosio_assert((has_auth(SYSTEMACCOUNT) || has_auth(AddressContract) || has_auth(TokenContract)
+                        || has_auth(TREASURYACCOUNT) || has_auth(REQOBTACCOUNT) || has_auth(FIOORACLEContract)
+                        || has_auth(EscrowContract) || has_auth(PERMSACCOUNT)),
+                                     "missing required authority of eosio, fio.address, fio.treasury, fio.token, fio.oracle fio.perms or fio.reqobt");
+                }
+                if (bountyamount > 0) {
+                        require_auth(TREASURYACCOUNT);
+                }
+                eosio_assert((has_auth(AddressContract) || has_auth(TokenContract) || has_auth(StakingContract) || has_auth(TREASURYACCOUNT)
+                || has_auth(REQOBTACCOUNT) || has_auth(SYSTEMACCOUNT) || has_auth(FeeContract) || has_auth(FIOORACLEContract)
+                || has_auth(EscrowContract) || has_auth(PERMSACCOUNT)),
+                             "missing required authority of fio.address, fio.token, fio.staking, fio.fee, fio.treasury, fio.oracle fio.perms or fio.reqobt");
+
+                rewardaccum accrued = rewardaccums.get_or_default();
+                accrued.bprewards += bpamount;
+                accrued.bppool += bppoolamount;
+                accrued.fdtnrewards += fdtnamount;
+                accrued.bounty += bountyamount;
+                rewardaccums.set(accrued, get_self());
+        }
+
+        //this action may be called by any account to apply the accrued fee rewards to the reward pools.
+        // @abi action
+        [[eosio::action]]
+        void settlerwds(const name &actor) {
+                require_auth(actor);
+
+                fio_400_assert(settle_rewards(), "settlerwds", "settlerwds",
+                               "No work.", ErrorNoWork);
+
+                const string response_string = string("{\"status\": \"OK\"}");
+                send_response(response_string.c_str());
+        }
+
         // @abi action
         [[eosio::action]]
         void fdtnrwdupdat(const uint64_t &amount) {
@@ -458,5 +554,5 @@ public:
 };     //class FIOTreasury
 
 EOSIO_DISPATCH(FIOTreasury, (tpidclaim)(startclock)(bprewdupdate)(fdtnrwdupdat)(bppoolupdate)
-               (bpclaim)(paystake))
+               (bpclaim)(paystake)(accrrewards)(settlerwds))
 }
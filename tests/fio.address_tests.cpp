@@ -0,0 +1,195 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+class fio_address_tester : public fio_contracts_tester {
+public:
+
+    fio_address_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "nfts"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@nfts"));
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(seed11111111), "seed"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(seed11111111), "seed@seed"));
+        produce_blocks();
+    }
+
+    action_result addnft(const account_name &actor, const string &fio_address, const fc::variants &nfts) {
+        return push(N(fio.address), actor, N(addnft),
+                    mvo()("fio_address", fio_address)("nfts", nfts)("max_fee", 40 * SUF)("actor", actor)
+                            ("tpid", ""));
+    }
+
+    static mvo nft(const string &contract_address, const string &token_id) {
+        return mvo()("chain_code", "ETH")("contract_address", contract_address)("token_id", token_id)
+                ("url", "")("hash", "")("metadata", "");
+    }
+
+    //add NFTs to seed@seed until the nfts table holds total rows. three NFTs per action and ten actions
+    //per transaction, each NFT has its own token id.
+    void seed_nfts(const uint32_t &total) {
+        uint32_t next = table_count(N(fio.address), N(fio.address), N(nfts));
+        while (next < total) {
+            signed_transaction trx;
+            for (int a = 0; a < 10 && next < total; a++) {
+                fc::variants nfts;
+                for (int n = 0; n < 3 && next < total; n++, next++) {
+                    nfts.push_back(nft("0xseedcontract", std::to_string(next)));
+                }
+                auto &ser = abi_sers.at(N(fio.address));
+                trx.actions.emplace_back(vector<permission_level>{{N(seed11111111), config::active_name}},
+                                         N(fio.address), N(addnft),
+                                         ser.variant_to_binary("addnft",
+                                                               mvo()("fio_address", "seed@seed")("nfts", nfts)
+                                                                       ("max_fee", 40 * SUF)
+                                                                       ("actor", "seed11111111")("tpid", ""),
+                                                               abi_serializer_max_time));
+            }
+            set_transaction_headers(trx);
+            trx.sign(get_private_key(N(seed11111111), "active"), control->get_chain_id());
+            push_transaction(trx);
+            if (next % 3000 == 0) produce_block();
+        }
+        produce_blocks();
+    }
+
+    //the median cpu time of removing an NFT with an empty token_id from alice@nfts.
+    int64_t remnft_empty_token_id_elapsed() {
+        vector <int64_t> elapsed;
+        for (int i = 0; i < 5; i++) {
+            BOOST_REQUIRE_EQUAL(success(), addnft(N(alice1111111), "alice@nfts", {nft("0xalicecontract", "")}));
+            produce_block();
+
+            auto trace = push_trace(N(fio.address), N(alice1111111), N(remnft),
+                                    mvo()("fio_address", "alice@nfts")
+                                            ("nfts", fc::variants{mvo()("chain_code", "ETH")
+                                                                          ("contract_address", "0xalicecontract")
+                                                                          ("token_id", "")})
+                                            ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", ""));
+            elapsed.push_back(trace->elapsed.count());
+            produce_block();
+        }
+        std::sort(elapsed.begin(), elapsed.end());
+        return elapsed[elapsed.size() / 2];
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_address_tests)
+
+BOOST_FIXTURE_TEST_CASE( remnft_empty_token_id_removes_only_the_address_nft, fio_address_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), addnft(N(alice1111111), "alice@nfts",
+                                          {nft("0xalicecontract", ""), nft("0xalicecontract", "7")}));
+    BOOST_REQUIRE_EQUAL(success(), addnft(N(seed11111111), "seed@seed", {nft("0xalicecontract", "")}));
+    produce_blocks();
+    BOOST_REQUIRE_EQUAL(3, table_count(N(fio.address), N(fio.address), N(nfts)));
+
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), N(alice1111111), N(remnft),
+                                        mvo()("fio_address", "alice@nfts")
+                                                ("nfts", fc::variants{mvo()("chain_code", "ETH")
+                                                                              ("contract_address", "0xalicecontract")
+                                                                              ("token_id", "")})
+                                                ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", "")));
+
+    //the NFT with the token id and the NFT of seed@seed using the same contract are kept.
+    uint32_t alice = 0;
+    uint32_t seed = 0;
+    for_each_row(N(fio.address), N(fio.address), N(nfts), "nftinfo", [&](const fc::variant &row) {
+        if (row["fio_address"].as_string() == "alice@nfts") {
+            BOOST_REQUIRE_EQUAL("7", row["token_id"].as_string());
+            alice++;
+        } else {
+            BOOST_REQUIRE_EQUAL("", row["token_id"].as_string());
+            seed++;
+        }
+    });
+    BOOST_REQUIRE_EQUAL(1, alice);
+    BOOST_REQUIRE_EQUAL(1, seed);
+
+    //nothing left to remove with an empty token id.
+    BOOST_REQUIRE(is_fio_400(push(N(fio.address), N(alice1111111), N(remnft),
+                                  mvo()("fio_address", "alice@nfts")
+                                          ("nfts", fc::variants{mvo()("chain_code", "ETH")
+                                                                        ("contract_address", "0xalicecontract")
+                                                                        ("token_id", "")})
+                                          ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", "")),
+                             "fio_address", "No NFTs"));
+} FC_LOG_AND_RETHROW()
+
+//the empty token_id cleanup walks only the NFTs of the fio address, its cost must not follow the size of
+//the nfts table. 100k NFTs mapped to another address may not make it more than a few times slower than
+//with 1k, the linear scan this replaced was about 100 times slower.
+BOOST_FIXTURE_TEST_CASE( remnft_empty_token_id_scaling, fio_address_tester ) try {
+    seed_nfts(1000);
+    const int64_t small = remnft_empty_token_id_elapsed();
+
+    seed_nfts(100000);
+    BOOST_REQUIRE_EQUAL(100000, table_count(N(fio.address), N(fio.address), N(nfts)));
+    const int64_t large = remnft_empty_token_id_elapsed();
+
+    BOOST_TEST_MESSAGE("remnft empty token_id cpu us, 1k nfts: " << small << ", 100k nfts: " << large);
+    BOOST_REQUIRE_LE(large, 4 * small + 500);
+} FC_LOG_AND_RETHROW()
+
+//migrpubaddr indexes every fioname once, fionamepubs then holds exactly the addresses of fioname::addresses.
+BOOST_FIXTURE_TEST_CASE( migrpubaddr_indexes_every_fioname, fio_address_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), N(alice1111111), N(addaddress),
+                                        mvo()("fio_address", "alice@nfts")
+                                                ("public_addresses", fc::variants{
+                                                        mvo()("token_code", "ETH")("chain_code", "ETH")
+                                                                ("public_address", "0xalice")})
+                                                ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", "")));
+
+    BOOST_REQUIRE(is_fio_400(push(N(fio.address), N(carol1111111), N(migrpubaddr),
+                                  mvo()("amount", 25)("actor", "carol1111111")),
+                             "actor", "Actor not active producer"));
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(alice1111111), "alice@nfts"));
+
+    //one fioname per call, the second of the two fionames finishes the migration.
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), N(alice1111111), N(migrpubaddr),
+                                        mvo()("amount", 1)("actor", "alice1111111")));
+    auto migr = get_singleton(N(fio.address), N(pubmigrinfo), "pubmigrinfo");
+    BOOST_REQUIRE_EQUAL(false, migr["finished"].as<bool>());
+    BOOST_REQUIRE_EQUAL(1, migr["next_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), N(alice1111111), N(migrpubaddr),
+                                        mvo()("amount", 25)("actor", "alice1111111")));
+    migr = get_singleton(N(fio.address), N(pubmigrinfo), "pubmigrinfo");
+    BOOST_REQUIRE_EQUAL(true, migr["finished"].as<bool>());
+    BOOST_REQUIRE(is_fio_400(push(N(fio.address), N(alice1111111), N(migrpubaddr),
+                                  mvo()("amount", 25)("actor", "alice1111111")),
+                             "migrpubaddr", "No Work."));
+
+    for (const auto &address : {"alice@nfts", "seed@seed"}) {
+        const auto fioname = get_fioname(address);
+        const uint64_t id = fioname["id"].as<uint64_t>();
+        std::map <string, string> pubs;
+        for_each_row(N(fio.address), N(fio.address), N(fionamepubs), "fionamepub", [&](const fc::variant &row) {
+            if (row["fionameid"].as<uint64_t>() == id) {
+                const string key = row["token_code"].as_string() + ":" + row["chain_code"].as_string();
+                BOOST_REQUIRE(pubs.find(key) == pubs.end());
+                pubs[key] = row["public_address"].as_string();
+            }
+        });
+        const auto &addresses = fioname["addresses"].get_array();
+        BOOST_REQUIRE_EQUAL(addresses.size(), pubs.size());
+        for (const auto &tpa : addresses) {
+            BOOST_REQUIRE_EQUAL(tpa["public_address"].as_string(),
+                                pubs[tpa["token_code"].as_string() + ":" + tpa["chain_code"].as_string()]);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(3, table_count(N(fio.address), N(fio.address), N(fionamepubs)));
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+class fio_common_tester : public fio_contracts_tester {
+public:
+
+    fio_common_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(bob111111111), "bob"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(bob111111111), "bob@bob"));
+        produce_blocks();
+    }
+
+    transaction_trace_ptr regaddress(const string &fio_address) {
+        return push_trace(N(fio.address), N(alice1111111), N(regaddress),
+                          mvo()("fio_address", fio_address)("owner_fio_public_key", "")
+                                  ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", ""));
+    }
+
+    transaction_trace_ptr addaddress(const string &token_code) {
+        return push_trace(N(fio.address), N(alice1111111), N(addaddress),
+                          mvo()("fio_address", "alice@alice")
+                                  ("public_addresses", fc::variants{
+                                          mvo()("token_code", token_code)("chain_code", token_code)
+                                                  ("public_address", "0xalice")})
+                                  ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", ""));
+    }
+
+    transaction_trace_ptr newfundsreq() {
+        return push_trace(N(fio.reqobt), N(alice1111111), N(newfundsreq),
+                          mvo()("payer_fio_address", "bob@bob")("payee_fio_address", "alice@alice")
+                                  ("content", string(64, 'c'))("max_fee", 40 * SUF)("actor", "alice1111111")
+                                  ("tpid", ""));
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_common_tests)
+
+//the error payload of a failed fio_400_assert is built only on failure, it is the same json as before.
+BOOST_FIXTURE_TEST_CASE( fio_400_payload_is_unchanged, fio_common_tester ) try {
+    const auto result = push(N(fio.address), N(alice1111111), N(regaddress),
+                             mvo()("fio_address", "alice2@alice")("owner_fio_public_key", "")
+                                     ("max_fee", 1)("actor", "alice1111111")("tpid", ""));
+    BOOST_REQUIRE(result.find("{\n  \"type\": \"invalid_input\",\n"
+                              "  \"message\": \"An invalid request was sent in, please check the nested errors "
+                              "for details.\",\n"
+                              "  \"fields\": [\n"
+                              "    {\"name\": \"max_fee\",\n"
+                              "    \"value\": \"1\",\n"
+                              "    \"error\": \"Fee exceeds supplied maximum.\"}]\n}\n") != string::npos);
+} FC_LOG_AND_RETHROW()
+
+//the cpu billed for three actions that pass several fio_400_assert checks each. run against a build of the
+//contracts before the lazy macros to compare, with --log_level=message.
+BOOST_FIXTURE_TEST_CASE( assert_macros_cpu, fio_common_tester ) try {
+    int i = 0;
+    const int64_t regaddress_us = median_elapsed([&]() {
+        return regaddress("alice" + std::to_string(i++) + "@alice");
+    });
+    const string tokens[] = {"AAA", "BBB", "CCC", "DDD", "EEE"};
+    i = 0;
+    const int64_t addaddress_us = median_elapsed([&]() { return addaddress(tokens[i++]); });
+    const int64_t newfundsreq_us = median_elapsed([&]() { return newfundsreq(); });
+
+    BOOST_TEST_MESSAGE("cpu us, regaddress: " << regaddress_us << ", addaddress: " << addaddress_us
+                                              << ", newfundsreq: " << newfundsreq_us);
+    BOOST_REQUIRE_GT(regaddress_us, 0);
+    BOOST_REQUIRE_GT(addaddress_us, 0);
+    BOOST_REQUIRE_GT(newfundsreq_us, 0);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,243 @@
+/**
+ *  @file
+ *  @copyright defined in fio.contracts/LICENSE
+ */
+#pragma once
+
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include "contracts.hpp"
+
+#include <fc/variant_object.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace fc;
+
+using mvo = fc::mutable_variant_object;
+
+#ifndef TESTER
+#ifdef NON_VALIDATING_TEST
+#define TESTER tester
+#else
+#define TESTER validating_tester
+#endif
+#endif
+
+namespace fio_contracts {
+
+    //one FIO in SUFs.
+    static constexpr int64_t SUF = 1000000000;
+
+    //a chain with the FIO contracts deployed, the fees used by the tests created and funded, bound accounts.
+    class fio_contracts_tester : public TESTER {
+    public:
+
+        fio_contracts_tester() {
+            produce_blocks(2);
+
+            //accounts are created before fio.system is deployed, the native newaccount of fio.system
+            //only permits eosio, fio.token and fio.address to create accounts.
+            create_accounts({N(fio.token), N(fio.address), N(fio.fee), N(fio.tpid), N(fio.treasury),
+                             N(fio.reqobt), N(fio.staking), N(eosio.ram), N(eosio.ramfee), N(eosio.stake),
+                             N(eosio.bpay), N(eosio.vpay), N(eosio.saving), N(eosio.names), N(tw4tjkmo4eyd)});
+            create_accounts({N(alice1111111), N(bob111111111), N(carol1111111), N(seed11111111)});
+            produce_blocks();
+
+            deploy(config::system_account_name, contracts::system_wasm(), contracts::system_abi());
+            deploy(N(fio.token), contracts::token_wasm(), contracts::token_abi());
+            deploy(N(fio.address), contracts::address_wasm(), contracts::address_abi());
+            deploy(N(fio.fee), contracts::fee_wasm(), contracts::fee_abi());
+            deploy(N(fio.tpid), contracts::tpid_wasm(), contracts::tpid_abi());
+            deploy(N(fio.treasury), contracts::treasury_wasm(), contracts::treasury_abi());
+            deploy(N(fio.reqobt), contracts::reqobt_wasm(), contracts::reqobt_abi());
+            deploy(N(fio.staking), contracts::staking_wasm(), contracts::staking_abi());
+
+            for (auto contract : {N(fio.token), N(fio.address), N(fio.fee), N(fio.tpid), N(fio.treasury),
+                                  N(fio.reqobt), N(fio.staking)}) {
+                BOOST_REQUIRE_EQUAL(success(), push(config::system_account_name, config::system_account_name,
+                                                    N(setpriv), mvo()("account", contract)("ispriv", 1)));
+            }
+
+            BOOST_REQUIRE_EQUAL(success(), push(N(fio.token), N(fio.token), N(create),
+                                                mvo()("maximum_supply", "1000000000.000000000 FIO")));
+
+            create_fee("register_fio_domain", 0, 40 * SUF);
+            create_fee("register_fio_address", 0, 2 * SUF);
+            create_fee("add_pub_address", 1, SUF / 2);
+            create_fee("transfer_tokens_pub_key", 0, 2 * SUF);
+            create_fee("remove_pub_address", 1, SUF / 2);
+            create_fee("add_nft", 1, SUF / 2);
+            create_fee("remove_nft", 1, SUF / 2);
+            create_fee("new_funds_request", 1, SUF / 2);
+            create_fee("reject_funds_request", 1, SUF / 2);
+            create_fee("record_obt_data", 1, SUF / 2);
+            create_fee("register_producer", 0, 10 * SUF);
+            create_fee("vote_producer", 1, SUF / 2);
+            create_fee("stake_fio_tokens", 1, 3 * SUF);
+            create_fee("unstake_fio_tokens", 1, 3 * SUF);
+
+            //fees paid with a tpid read the minted bounty, it must exist from genesis.
+            BOOST_REQUIRE_EQUAL(success(), push(N(fio.tpid), N(fio.tpid), N(updatebounty), mvo()("amount", 0)));
+
+            for (auto account : {N(alice1111111), N(bob111111111), N(carol1111111), N(seed11111111)}) {
+                bind_account(account, 100000 * SUF);
+            }
+            produce_blocks();
+        }
+
+        void deploy(const account_name &account, const std::vector <uint8_t> &wasm, const std::vector<char> &abi) {
+            set_code(account, wasm);
+            set_abi(account, abi.data());
+
+            const auto &accnt = control->db().get<account_object, by_name>(account);
+            abi_def abidef;
+            BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abidef), true);
+            abi_sers[account].set_abi(abidef, abi_serializer_max_time);
+        }
+
+        action_result push(const account_name &contract, const account_name &signer, const action_name &name,
+                           const variant_object &data) {
+            auto &ser = abi_sers.at(contract);
+            action act;
+            act.account = contract;
+            act.name = name;
+            act.data = ser.variant_to_binary(ser.get_action_type(name), data, abi_serializer_max_time);
+
+            return base_tester::push_action(std::move(act), uint64_t(signer));
+        }
+
+        //push an action that must succeed and return its trace, used where the test reads the cpu billed.
+        transaction_trace_ptr push_trace(const account_name &contract, const account_name &signer,
+                                         const action_name &name, const variant_object &data) {
+            return base_tester::push_action(contract, name, signer, data);
+        }
+
+        //the number of actions with the given name in a transaction, inline actions included.
+        int count_actions(const transaction_trace_ptr &trace, const action_name &name) {
+            int count = 0;
+            for (const auto &at : trace->action_traces) {
+                if (at.act.name == name) count++;
+            }
+            return count;
+        }
+
+        //the median time the actions of a transaction took over a few runs, a block is produced after each
+        //run so the next one is a new transaction. printed by the cpu tests with --log_level=message.
+        int64_t median_elapsed(const std::function<transaction_trace_ptr()> &run, const int &runs = 5) {
+            vector <int64_t> elapsed;
+            for (int i = 0; i < runs; i++) {
+                elapsed.push_back(run()->elapsed.count());
+                produce_block();
+            }
+            std::sort(elapsed.begin(), elapsed.end());
+            return elapsed[elapsed.size() / 2];
+        }
+
+        fc::variant get_row(const account_name &contract, const name &scope, const name &table,
+                            const string &type, const uint64_t &key) {
+            vector<char> data = get_row_by_account(contract, scope, table, key);
+            return data.empty() ? fc::variant() : abi_sers.at(contract).binary_to_variant(type, data,
+                                                                                          abi_serializer_max_time);
+        }
+
+        fc::variant get_singleton(const account_name &contract, const name &table, const string &type) {
+            return get_row(contract, contract, table, type, table.value);
+        }
+
+        //visit every row of a table in primary key order.
+        void for_each_row(const account_name &contract, const name &scope, const name &table, const string &type,
+                          const std::function<void(const fc::variant &)> &f) {
+            const auto &db = control->db();
+            const auto *t_id = db.find<table_id_object, by_code_scope_table>(
+                    boost::make_tuple(contract, scope, table));
+            if (t_id == nullptr) return;
+
+            const auto &idx = db.get_index<key_value_index, by_scope_primary>();
+            for (auto itr = idx.lower_bound(boost::make_tuple(t_id->id, 0));
+                 itr != idx.end() && itr->t_id == t_id->id; ++itr) {
+                vector<char> data(itr->value.data(), itr->value.data() + itr->value.size());
+                f(abi_sers.at(contract).binary_to_variant(type, data, abi_serializer_max_time));
+            }
+        }
+
+        uint32_t table_count(const account_name &contract, const name &scope, const name &table) {
+            const auto *t_id = control->db().find<table_id_object, by_code_scope_table>(
+                    boost::make_tuple(contract, scope, table));
+            return t_id == nullptr ? 0 : t_id->count;
+        }
+
+        //true when an action failed with the fio_400_assert error of the given field.
+        static bool is_fio_400(const action_result &result, const string &field, const string &error) {
+            return result.find("\"name\": \"" + field + "\"") != string::npos &&
+                   result.find("\"error\": \"" + error + "\"") != string::npos;
+        }
+
+        //the fionames row of a fio address, null when it is not registered.
+        fc::variant get_fioname(const string &fio_address) {
+            fc::variant found;
+            for_each_row(N(fio.address), N(fio.address), N(fionames), "fioname", [&](const fc::variant &row) {
+                if (row["name"].as_string() == fio_address) found = row;
+            });
+            return found;
+        }
+
+        int64_t get_balance(const account_name &account) {
+            vector<char> data = get_row_by_account(N(fio.token), account, N(accounts),
+                                                   symbol(9, "FIO").to_symbol_code().value);
+            if (data.empty()) return 0;
+            return abi_sers.at(N(fio.token)).binary_to_variant("account", data, abi_serializer_max_time)
+                    ["balance"].as<asset>().get_amount();
+        }
+
+        //the FIO form of the active key of a tester account.
+        string fio_key(const account_name &account) {
+            const string key = string(get_public_key(account, "active"));
+            return "FIO" + key.substr(3);
+        }
+
+        void create_fee(const string &end_point, const int64_t &type, const int64_t &suf_amount) {
+            BOOST_REQUIRE_EQUAL(success(), push(N(fio.fee), N(fio.fee), N(createfee),
+                                                mvo()("end_point", end_point)("type", type)
+                                                        ("suf_amount", suf_amount)));
+        }
+
+        //bind an existing account to its key in the accountmap and fund it.
+        void bind_account(const account_name &account, const int64_t &amount) {
+            BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), config::system_account_name, N(bind2eosio),
+                                                mvo()("account", account)("client_key", fio_key(account))
+                                                        ("existing", false)));
+            BOOST_REQUIRE_EQUAL(success(), push(N(fio.token), config::system_account_name, N(issue),
+                                                mvo()("to", account)
+                                                        ("quantity", asset(amount, symbol(9, "FIO")))
+                                                        ("memo", "")));
+        }
+
+        action_result register_domain(const account_name &actor, const string &fio_domain) {
+            return push(N(fio.address), actor, N(regdomain),
+                        mvo()("fio_domain", fio_domain)("owner_fio_public_key", "")
+                                ("max_fee", 800 * SUF)("actor", actor)("tpid", ""));
+        }
+
+        action_result register_address(const account_name &actor, const string &fio_address,
+                                       const string &tpid = "") {
+            return push(N(fio.address), actor, N(regaddress),
+                        mvo()("fio_address", fio_address)("owner_fio_public_key", "")
+                                ("max_fee", 40 * SUF)("actor", actor)("tpid", tpid));
+        }
+
+        //register the account as a producer using a fio address it owns.
+        action_result register_producer(const account_name &actor, const string &fio_address) {
+            return push(config::system_account_name, actor, N(regproducer),
+                        mvo()("fio_address", fio_address)("fio_pub_key", fio_key(actor))
+                                ("url", "https://producer.example")("location", 80)("actor", actor)("max_fee", 40 * SUF));
+        }
+
+        std::map <account_name, abi_serializer> abi_sers;
+    };
+
+} //ns fio_contracts
@@ -0,0 +1,76 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+class fio_fee_tester : public fio_contracts_tester {
+public:
+
+    //the fiofees row of an endpoint, null when no fee exists.
+    fc::variant get_fee(const string &end_point) {
+        fc::variant found;
+        for_each_row(N(fio.fee), N(fio.fee), N(fiofees), "fiofee", [&](const fc::variant &row) {
+            if (row["end_point"].as_string() == end_point) found = row;
+        });
+        return found;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_fee_tests)
+
+//built in fees are created at their index in BUILTIN_FEE_ENDPOINTS, whatever the creation order.
+BOOST_FIXTURE_TEST_CASE( builtin_fees_take_their_fixed_id, fio_fee_tester ) try {
+    BOOST_REQUIRE_EQUAL(0, get_fee("register_fio_domain")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(1, get_fee("register_fio_address")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(4, get_fee("add_pub_address")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(5, get_fee("transfer_tokens_pub_key")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(6, get_fee("new_funds_request")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(8, get_fee("record_obt_data")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(10, get_fee("register_producer")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(27, get_fee("add_nft")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(28, get_fee("remove_nft")["fee_id"].as<uint64_t>());
+
+    //an existing fee is updated in place.
+    create_fee("register_fio_address", 0, 3 * SUF);
+    const auto fee = get_fee("register_fio_address");
+    BOOST_REQUIRE_EQUAL(1, fee["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(3 * SUF, fee["suf_amount"].as<int64_t>());
+
+    //the fee read by fixed id is the one charged.
+    const int64_t balance = get_balance(N(alice1111111));
+    BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+    BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+    BOOST_REQUIRE_EQUAL(balance - 43 * SUF, get_balance(N(alice1111111)));
+} FC_LOG_AND_RETHROW()
+
+//a built in fee whose fixed id is taken gets the next free id and is found through the byendpoint index.
+BOOST_FIXTURE_TEST_CASE( builtin_fee_falls_back_when_its_id_is_taken, fio_fee_tester ) try {
+    //the fixture created ids 0 to 31, unstake_fio_tokens is the highest. the next free id is the fixed id of
+    //wrap_fio_tokens, which a fee that is not built in takes first.
+    BOOST_REQUIRE_EQUAL(31, get_fee("unstake_fio_tokens")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE(get_fee("wrap_fio_tokens").is_null());
+    create_fee("not_a_builtin_endpoint", 1, SUF);
+    BOOST_REQUIRE_EQUAL(32, get_fee("not_a_builtin_endpoint")["fee_id"].as<uint64_t>());
+
+    create_fee("wrap_fio_tokens", 0, 5 * SUF);
+    BOOST_REQUIRE_EQUAL(33, get_fee("wrap_fio_tokens")["fee_id"].as<uint64_t>());
+
+    //updating it finds the row by endpoint, the row at the fixed id is left alone.
+    create_fee("wrap_fio_tokens", 0, 6 * SUF);
+    BOOST_REQUIRE_EQUAL(33, get_fee("wrap_fio_tokens")["fee_id"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(6 * SUF, get_fee("wrap_fio_tokens")["suf_amount"].as<int64_t>());
+    BOOST_REQUIRE_EQUAL(SUF, get_fee("not_a_builtin_endpoint")["suf_amount"].as<int64_t>());
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
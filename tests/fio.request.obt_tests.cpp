@@ -0,0 +1,343 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/resource_limits.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+//the encrypted content of a request or obt record, the contract requires at least 64 characters.
+static const string CONTENT(64, 'c');
+
+class fio_request_obt_tester : public fio_contracts_tester {
+public:
+
+    fio_request_obt_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(bob111111111), "bob"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(bob111111111), "bob@bob"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(bob111111111), "bob2@bob"));
+        produce_blocks();
+    }
+
+    //alice@alice requests funds from the payer.
+    action_result newfundsreq(const string &payer_fio_address) {
+        return push(N(fio.reqobt), N(alice1111111), N(newfundsreq),
+                    mvo()("payer_fio_address", payer_fio_address)("payee_fio_address", "alice@alice")
+                            ("content", CONTENT)("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", ""));
+    }
+
+    //bob@bob records a send of funds to alice@alice.
+    action_result recordobt(const string &fio_request_id) {
+        return push(N(fio.reqobt), N(bob111111111), N(recordobt),
+                    mvo()("fio_request_id", fio_request_id)("payer_fio_address", "bob@bob")
+                            ("payee_fio_address", "alice@alice")("content", CONTENT)("max_fee", 40 * SUF)
+                            ("actor", "bob111111111")("tpid", ""));
+    }
+
+    action_result prunetrx(const uint16_t &amount) {
+        return push(N(fio.reqobt), N(carol1111111), N(prunetrx),
+                    mvo()("amount", amount)("actor", "carol1111111"));
+    }
+
+    action_result setretention(const uint32_t &max_age, const bool &keep_stub) {
+        return push(N(fio.reqobt), config::system_account_name, N(setretention),
+                    mvo()("max_age", max_age)("keep_stub", keep_stub));
+    }
+
+    uint64_t pruned() {
+        return get_singleton(N(fio.reqobt), N(trxretention), "trxretention")["pruned"].as<uint64_t>();
+    }
+
+    vector <fc::variant> trx_rows() {
+        vector <fc::variant> rows;
+        for_each_row(N(fio.reqobt), N(fio.reqobt), N(fiotrxtss), "fiotrxt_info",
+                     [&](const fc::variant &row) { rows.push_back(row); });
+        return rows;
+    }
+
+    uint32_t bundles(const string &fio_address) {
+        return get_fioname(fio_address)["bundleeligiblecountdown"].as<uint32_t>();
+    }
+
+    int64_t ram_usage(const account_name &account) {
+        return control->get_resource_limits_manager().get_account_ram_usage(account);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_request_obt_tests)
+
+//requests and obt records are written to fiotrxtss, the table read by the chain api, with the address
+//strings and keys of both parties.
+BOOST_FIXTURE_TEST_CASE( rows_are_written_to_fiotrxtss, fio_request_obt_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    BOOST_REQUIRE_EQUAL(success(), recordobt(""));
+    produce_blocks();
+
+    const auto rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(2, rows.size());
+    for (const auto &row : rows) {
+        BOOST_REQUIRE_EQUAL("bob@bob", row["payer_fio_addr"].as_string());
+        BOOST_REQUIRE_EQUAL("alice@alice", row["payee_fio_addr"].as_string());
+        BOOST_REQUIRE_EQUAL(fio_key(N(bob111111111)), row["payer_key"].as_string());
+        BOOST_REQUIRE_EQUAL(fio_key(N(alice1111111)), row["payee_key"].as_string());
+    }
+    BOOST_REQUIRE_EQUAL(0, rows[0]["fio_data_type"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(4, rows[1]["fio_data_type"].as<uint32_t>());
+
+    //a request is found by its fio_request_id, the obt record moves it to sent_to_blockchain.
+    const string request_id = rows[0]["fio_request_id"].as_string();
+    BOOST_REQUIRE_EQUAL(success(), recordobt(request_id));
+    BOOST_REQUIRE_EQUAL(2, trx_rows()[0]["fio_data_type"].as<uint32_t>());
+    BOOST_REQUIRE(is_fio_400(recordobt(request_id), "fio_request_id", "Only pending requests can be responded."));
+} FC_LOG_AND_RETHROW()
+
+//migrtrx may only be called by producers and leaves fiotrxtss alone.
+BOOST_FIXTURE_TEST_CASE( migrtrx_requires_a_producer, fio_request_obt_tester ) try {
+    BOOST_REQUIRE(is_fio_400(push(N(fio.reqobt), N(carol1111111), N(migrtrx),
+                                  mvo()("amount", 25)("actor", "carol1111111")),
+                             "actor", "Actor not active producer"));
+
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(bob111111111), "bob@bob"));
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.reqobt), N(bob111111111), N(migrtrx),
+                                        mvo()("amount", 25)("actor", "bob111111111")));
+    BOOST_REQUIRE_EQUAL(1, trx_rows().size());
+} FC_LOG_AND_RETHROW()
+
+//the RAM billed per request and the cpu of each status change of the fiotrxtss layout, printed with
+//--log_level=message. these are the numbers a layout with fewer secondary indexes is measured against.
+BOOST_FIXTURE_TEST_CASE( request_ram_and_status_change_cpu, fio_request_obt_tester ) try {
+    const int64_t ram = ram_usage(N(alice1111111));
+    for (int i = 0; i < 15; i++) {
+        BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    }
+    const int64_t ram_per_request = (ram_usage(N(alice1111111)) - ram) / 15;
+    produce_blocks();
+
+    vector <string> ids;
+    for (const auto &row : trx_rows()) ids.push_back(row["fio_request_id"].as_string());
+
+    size_t next = 0;
+    const int64_t reject = median_elapsed([&]() {
+        return push_trace(N(fio.reqobt), N(bob111111111), N(rejectfndreq),
+                          mvo()("fio_request_id", ids[next++])("max_fee", 40 * SUF)("actor", "bob111111111")
+                                  ("tpid", ""));
+    });
+    const int64_t cancel = median_elapsed([&]() {
+        return push_trace(N(fio.reqobt), N(alice1111111), N(cancelfndreq),
+                          mvo()("fio_request_id", ids[next++])("max_fee", 40 * SUF)("actor", "alice1111111")
+                                  ("tpid", ""));
+    });
+    const int64_t obt = median_elapsed([&]() {
+        return push_trace(N(fio.reqobt), N(bob111111111), N(recordobt),
+                          mvo()("fio_request_id", ids[next++])("payer_fio_address", "bob@bob")
+                                  ("payee_fio_address", "alice@alice")("content", CONTENT)("max_fee", 40 * SUF)
+                                  ("actor", "bob111111111")("tpid", ""));
+    });
+
+    BOOST_TEST_MESSAGE("fiotrxtss ram bytes per request: " << ram_per_request << ", status change cpu us, reject: "
+                                                           << reject << ", cancel: " << cancel
+                                                           << ", recordobt: " << obt);
+    BOOST_REQUIRE_GT(ram_per_request, 0);
+    for (const auto &row : trx_rows()) {
+        BOOST_REQUIRE_NE(0, row["fio_data_type"].as<uint32_t>());
+    }
+} FC_LOG_AND_RETHROW()
+
+//a request charges 2 bundles to fioname::bundleeligiblecountdown of the payee, an obt record to the payer.
+BOOST_FIXTURE_TEST_CASE( bundles_are_charged_on_the_fioname, fio_request_obt_tester ) try {
+    const uint32_t alice = bundles("alice@alice");
+    const uint32_t bob = bundles("bob@bob");
+    const int64_t alice_balance = get_balance(N(alice1111111));
+    BOOST_REQUIRE_GE(alice, 2);
+
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    BOOST_REQUIRE_EQUAL(alice - 2, bundles("alice@alice"));
+    BOOST_REQUIRE_EQUAL(alice_balance, get_balance(N(alice1111111)));
+
+    BOOST_REQUIRE_EQUAL(success(), recordobt(""));
+    BOOST_REQUIRE_EQUAL(bob - 2, bundles("bob@bob"));
+    BOOST_REQUIRE_EQUAL(alice - 2, bundles("alice@alice"));
+} FC_LOG_AND_RETHROW()
+
+//the bundles of a request and an obt record are charged by one decrbundle on the resolved fioname id, the
+//median cpu of both is printed with --log_level=message.
+BOOST_FIXTURE_TEST_CASE( bundle_charge_cpu, fio_request_obt_tester ) try {
+    const auto trace = push_trace(N(fio.reqobt), N(alice1111111), N(newfundsreq),
+                                  mvo()("payer_fio_address", "bob@bob")("payee_fio_address", "alice@alice")
+                                          ("content", CONTENT)("max_fee", 40 * SUF)("actor", "alice1111111")
+                                          ("tpid", ""));
+    BOOST_REQUIRE_EQUAL(1, count_actions(trace, N(decrbundle)));
+    BOOST_REQUIRE_EQUAL(0, count_actions(trace, N(decrcounter)));
+    produce_blocks();
+
+    const int64_t request = median_elapsed([&]() {
+        return push_trace(N(fio.reqobt), N(alice1111111), N(newfundsreq),
+                          mvo()("payer_fio_address", "bob@bob")("payee_fio_address", "alice@alice")
+                                  ("content", CONTENT)("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", ""));
+    });
+    const int64_t obt = median_elapsed([&]() {
+        return push_trace(N(fio.reqobt), N(bob111111111), N(recordobt),
+                          mvo()("fio_request_id", "")("payer_fio_address", "bob@bob")
+                                  ("payee_fio_address", "alice@alice")("content", CONTENT)("max_fee", 40 * SUF)
+                                  ("actor", "bob111111111")("tpid", ""));
+    });
+    BOOST_TEST_MESSAGE("bundled cpu us, newfundsreq: " << request << ", recordobt: " << obt);
+} FC_LOG_AND_RETHROW()
+
+//a batch writes one row per item and charges the bundles of all items at once.
+BOOST_FIXTURE_TEST_CASE( batchfndreq_charges_once, fio_request_obt_tester ) try {
+    const uint32_t alice = bundles("alice@alice");
+    fc::variants requests;
+    for (const auto &payer : {"bob@bob", "bob2@bob", "bob@bob"}) {
+        requests.push_back(mvo()("payer_fio_address", payer)("content", CONTENT));
+    }
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.reqobt), N(alice1111111), N(batchfndreq),
+                                        mvo()("payee_fio_address", "alice@alice")("requests", requests)
+                                                ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", "")));
+    BOOST_REQUIRE_EQUAL(alice - 6, bundles("alice@alice"));
+
+    const auto rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(3, rows.size());
+    BOOST_REQUIRE_EQUAL("bob2@bob", rows[1]["payer_fio_addr"].as_string());
+    for (const auto &row : rows) {
+        BOOST_REQUIRE_EQUAL(0, row["fio_data_type"].as<uint32_t>());
+        BOOST_REQUIRE_EQUAL(row["id"].as_string(), row["fio_request_id"].as_string());
+        BOOST_REQUIRE_EQUAL(fio_key(N(bob111111111)), row["payer_key"].as_string());
+    }
+
+    //an unknown payer fails the whole batch.
+    requests.push_back(mvo()("payer_fio_address", "nobody@bob")("content", CONTENT));
+    BOOST_REQUIRE(is_fio_400(push(N(fio.reqobt), N(alice1111111), N(batchfndreq),
+                                  mvo()("payee_fio_address", "alice@alice")("requests", requests)
+                                          ("max_fee", 40 * SUF)("actor", "alice1111111")("tpid", "")),
+                             "payer_fio_address", "No such FIO Address"));
+    BOOST_REQUIRE_EQUAL(3, trx_rows().size());
+    BOOST_REQUIRE_EQUAL(alice - 6, bundles("alice@alice"));
+} FC_LOG_AND_RETHROW()
+
+//the records of a batch answer a request or add an obt row, bundles are charged once for all of them.
+BOOST_FIXTURE_TEST_CASE( batchrecobt_records_and_limits, fio_request_obt_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    const string request_id = trx_rows()[0]["fio_request_id"].as_string();
+    const uint32_t bob = bundles("bob@bob");
+
+    fc::variants records;
+    records.push_back(mvo()("fio_request_id", request_id)("payee_fio_address", "alice@alice")("content", CONTENT));
+    records.push_back(mvo()("fio_request_id", "")("payee_fio_address", "alice@alice")("content", CONTENT));
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.reqobt), N(bob111111111), N(batchrecobt),
+                                        mvo()("payer_fio_address", "bob@bob")("records", records)
+                                                ("max_fee", 40 * SUF)("actor", "bob111111111")("tpid", "")));
+    BOOST_REQUIRE_EQUAL(bob - 4, bundles("bob@bob"));
+
+    //the request is sent to the blockchain, the record without a request id is a new obt row.
+    const auto rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(2, rows.size());
+    for (const auto &row : rows) {
+        const uint32_t status = row["fio_data_type"].as<uint32_t>();
+        BOOST_REQUIRE(status == 2 || status == 4);
+    }
+
+    //at most 25 items per batch.
+    fc::variants toomany(26, mvo()("fio_request_id", "")("payee_fio_address", "alice@alice")("content", CONTENT));
+    BOOST_REQUIRE(is_fio_400(push(N(fio.reqobt), N(bob111111111), N(batchrecobt),
+                                  mvo()("payer_fio_address", "bob@bob")("records", toomany)
+                                          ("max_fee", 40 * SUF)("actor", "bob111111111")("tpid", "")),
+                             "records", "Invalid number of records"));
+} FC_LOG_AND_RETHROW()
+
+//terminal rows older than the retention are erased, open requests are kept, ids are never reused.
+BOOST_FIXTURE_TEST_CASE( prunetrx_erases_terminal_rows, fio_request_obt_tester ) try {
+    BOOST_REQUIRE(is_fio_400(prunetrx(25), "prunetrx", "No Work."));
+    BOOST_REQUIRE_EQUAL(wasm_assert_msg("missing required authority of eosio"),
+                        push(N(fio.reqobt), N(carol1111111), N(setretention),
+                             mvo()("max_age", 3600)("keep_stub", false)));
+    BOOST_REQUIRE_EQUAL(success(), setretention(3600, false));
+
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    const string rejected_id = trx_rows()[1]["fio_request_id"].as_string();
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.reqobt), N(bob111111111), N(rejectfndreq),
+                                        mvo()("fio_request_id", rejected_id)("max_fee", 40 * SUF)
+                                                ("actor", "bob111111111")("tpid", "")));
+    for (int i = 0; i < 3; i++) {
+        BOOST_REQUIRE_EQUAL(success(), recordobt(""));
+    }
+    produce_blocks();
+    uint64_t max_id = 0;
+    for (const auto &row : trx_rows()) max_id = std::max(max_id, row["id"].as<uint64_t>());
+
+    //nothing is old enough yet.
+    BOOST_REQUIRE(is_fio_400(prunetrx(25), "prunetrx", "No Work."));
+
+    produce_block(fc::seconds(3700));
+    BOOST_REQUIRE_EQUAL(success(), prunetrx(25));
+    auto rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(1, rows.size());
+    BOOST_REQUIRE_EQUAL(0, rows[0]["fio_data_type"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(4, pruned());
+    BOOST_REQUIRE(is_fio_400(prunetrx(25), "prunetrx", "No Work."));
+
+    //the highest id was pruned, the next request still gets a new one.
+    BOOST_REQUIRE_EQUAL(success(), newfundsreq("bob@bob"));
+    rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(2, rows.size());
+    BOOST_REQUIRE_GT(rows[1]["id"].as<uint64_t>(), max_id);
+} FC_LOG_AND_RETHROW()
+
+//with keep_stub the rows stay with the hash of their content, stubs are not visited again.
+BOOST_FIXTURE_TEST_CASE( prunetrx_keeps_stubs, fio_request_obt_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), setretention(3600, true));
+    //the three records share one obt_time, the cursor resumes between them by id.
+    signed_transaction trx;
+    for (int i = 0; i < 3; i++) {
+        auto &ser = abi_sers.at(N(fio.reqobt));
+        trx.actions.emplace_back(vector<permission_level>{{N(bob111111111), config::active_name}},
+                                 N(fio.reqobt), N(recordobt),
+                                 ser.variant_to_binary("recordobt",
+                                                       mvo()("fio_request_id", "")("payer_fio_address", "bob@bob")
+                                                               ("payee_fio_address", "alice@alice")
+                                                               ("content", CONTENT + std::to_string(i))
+                                                               ("max_fee", 40 * SUF)("actor", "bob111111111")
+                                                               ("tpid", ""),
+                                                       abi_serializer_max_time));
+    }
+    set_transaction_headers(trx);
+    trx.sign(get_private_key(N(bob111111111), "active"), control->get_chain_id());
+    push_transaction(trx);
+    produce_block(fc::seconds(3700));
+
+    //the amount bounds the rows pruned by one call.
+    BOOST_REQUIRE_EQUAL(success(), prunetrx(2));
+    BOOST_REQUIRE_EQUAL(2, pruned());
+    BOOST_REQUIRE_EQUAL(success(), prunetrx(25));
+
+    const auto rows = trx_rows();
+    BOOST_REQUIRE_EQUAL(3, rows.size());
+    for (int i = 0; i < 3; i++) {
+        BOOST_REQUIRE(rows[i].get_object().contains("content_hash"));
+        BOOST_REQUIRE_EQUAL(fc::sha256::hash(CONTENT + std::to_string(i)).str(), rows[i]["content_hash"].as_string());
+        BOOST_REQUIRE_EQUAL("", rows[i]["obt_content"].as_string());
+        BOOST_REQUIRE_EQUAL("", rows[i]["req_content"].as_string());
+    }
+    BOOST_REQUIRE_EQUAL(3, pruned());
+    BOOST_REQUIRE(is_fio_400(prunetrx(25), "prunetrx", "No Work."));
+
+    //a new policy starts over, rows already reduced to stubs are visited but not counted.
+    BOOST_REQUIRE_EQUAL(success(), setretention(3600, true));
+    BOOST_REQUIRE_EQUAL(success(), prunetrx(25));
+    BOOST_REQUIRE_EQUAL(3, pruned());
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
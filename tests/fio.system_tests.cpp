@@ -0,0 +1,274 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+class fio_system_tester : public fio_contracts_tester {
+public:
+
+    fio_system_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+        produce_blocks();
+    }
+
+    static mvo period(const int64_t &duration, const int64_t &amount) {
+        return mvo()("duration", duration)("amount", amount);
+    }
+
+    action_result addgenlocked(const account_name &owner, const fc::variants &periods, const int64_t &amount) {
+        return push(config::system_account_name, N(fio.token), N(addgenlocked),
+                    mvo()("owner", owner)("periods", periods)("canvote", true)("amount", amount));
+    }
+
+    action_result unlocktokens(const account_name &actor) {
+        return push(config::system_account_name, N(fio.token), N(unlocktokens), mvo()("actor", actor));
+    }
+
+    //transfer to bob111111111, the transfer fee is 2 FIO.
+    action_result transfer_to_bob(const account_name &actor, const int64_t &amount) {
+        return push(N(fio.token), actor, N(trnsfiopubky),
+                    mvo()("payee_public_key", fio_key(N(bob111111111)))("amount", amount)("max_fee", 40 * SUF)
+                            ("actor", actor)("tpid", ""));
+    }
+
+    //the general lock of the owner, null when it holds none.
+    fc::variant get_lock(const account_name &owner) {
+        fc::variant found;
+        for_each_row(config::system_account_name, config::system_account_name, N(locktokensv2),
+                     "locked_tokens_info_v2", [&](const fc::variant &row) {
+                    if (row["owner_account"].as<account_name>() == owner) found = row;
+                });
+        return found;
+    }
+
+    //the total votes of a producer.
+    double total_votes(const account_name &producer) {
+        double votes = 0;
+        for_each_row(config::system_account_name, config::system_account_name, N(producers), "producer_info",
+                     [&](const fc::variant &row) {
+                         if (row["owner"].as<account_name>() == producer) votes = row["total_votes"].as_double();
+                     });
+        return votes;
+    }
+
+    transaction_trace_ptr updatepower(const account_name &voter) {
+        return push_trace(config::system_account_name, config::system_account_name, N(updatepower),
+                          mvo()("voter", voter)("updateonly", true));
+    }
+
+    fc::variant get_restriction(const account_name &owner) {
+        return get_row(config::system_account_name, config::system_account_name, N(acctrestrict),
+                       "account_restriction", owner.value);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_system_tests)
+
+//migrrestrict records every lock owner once, the summaries written by addgenlocked are kept as they are.
+BOOST_FIXTURE_TEST_CASE( migrrestrict_keeps_existing_summaries, fio_system_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(carol1111111), {period(100, 10 * SUF), period(200, 20 * SUF)},
+                                                30 * SUF));
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(bob111111111), {period(100, 5 * SUF)}, 5 * SUF));
+    const auto carol = get_restriction(N(carol1111111));
+    BOOST_REQUIRE(!carol.is_null());
+    BOOST_REQUIRE_EQUAL(30 * SUF, carol["general_locked"].as<int64_t>());
+
+    BOOST_REQUIRE(is_fio_400(push(config::system_account_name, N(carol1111111), N(migrrestrict),
+                                  mvo()("amount", 25)("actor", "carol1111111")),
+                             "actor", "Actor not active producer"));
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(alice1111111), "alice@alice"));
+
+    BOOST_REQUIRE_EQUAL(success(), push(config::system_account_name, N(alice1111111), N(migrrestrict),
+                                        mvo()("amount", 1)("actor", "alice1111111")));
+    BOOST_REQUIRE_EQUAL(false, get_singleton(config::system_account_name, N(restrictmigr),
+                                             "restriction_migration")["finished"].as<bool>());
+    BOOST_REQUIRE_EQUAL(success(), push(config::system_account_name, N(alice1111111), N(migrrestrict),
+                                        mvo()("amount", 25)("actor", "alice1111111")));
+    BOOST_REQUIRE_EQUAL(true, get_singleton(config::system_account_name, N(restrictmigr),
+                                            "restriction_migration")["finished"].as<bool>());
+    BOOST_REQUIRE(is_fio_400(push(config::system_account_name, N(alice1111111), N(migrrestrict),
+                                  mvo()("amount", 25)("actor", "alice1111111")),
+                             "migrrestrict", "No Work."));
+
+    BOOST_REQUIRE_EQUAL(fc::json::to_string(carol), fc::json::to_string(get_restriction(N(carol1111111))));
+    BOOST_REQUIRE_EQUAL(5 * SUF, get_restriction(N(bob111111111))["general_locked"].as<int64_t>());
+    BOOST_REQUIRE(get_restriction(N(alice1111111)).is_null());
+} FC_LOG_AND_RETHROW()
+
+//each payout advances next_unlock to the next period, the lock is cleared by a fee only after final_unlock.
+BOOST_FIXTURE_TEST_CASE( general_lock_partial_payouts, fio_system_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(carol1111111), {period(100, 10 * SUF), period(200, 10 * SUF),
+                                                                  period(300, 10 * SUF)}, 30 * SUF));
+    auto lock = get_lock(N(carol1111111));
+    const uint32_t timestamp = lock["timestamp"].as<uint32_t>();
+    BOOST_REQUIRE_EQUAL(timestamp + 100, lock["next_unlock"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 300, lock["final_unlock"].as<uint32_t>());
+
+    //nothing is unlocked before the first period.
+    BOOST_REQUIRE(is_fio_400(transfer_to_bob(N(carol1111111), get_balance(N(carol1111111)) - 25 * SUF),
+                             "actor", "Funds locked"));
+    BOOST_REQUIRE_EQUAL(success(), unlocktokens(N(carol1111111)));
+    lock = get_lock(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(0, lock["payouts_performed"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(30 * SUF, lock["remaining_lock_amount"].as<int64_t>());
+
+    produce_block(fc::seconds(150));
+    BOOST_REQUIRE_EQUAL(success(), unlocktokens(N(carol1111111)));
+    lock = get_lock(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(1, lock["payouts_performed"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(20 * SUF, lock["remaining_lock_amount"].as<int64_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 200, lock["next_unlock"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 300, lock["final_unlock"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(20 * SUF, get_restriction(N(carol1111111))["general_locked"].as<int64_t>());
+
+    //the unlocked period may be spent, a fee paid before final_unlock keeps the lock.
+    BOOST_REQUIRE_EQUAL(success(), transfer_to_bob(N(carol1111111), get_balance(N(carol1111111)) - 25 * SUF));
+    BOOST_REQUIRE_EQUAL(23 * SUF, get_balance(N(carol1111111)));
+    BOOST_REQUIRE(!get_lock(N(carol1111111)).is_null());
+
+    produce_block(fc::seconds(100));
+    BOOST_REQUIRE_EQUAL(success(), unlocktokens(N(carol1111111)));
+    lock = get_lock(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(2, lock["payouts_performed"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(10 * SUF, lock["remaining_lock_amount"].as<int64_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 300, lock["next_unlock"].as<uint32_t>());
+
+    //past final_unlock the next fee clears the lock and its summary.
+    produce_block(fc::seconds(100));
+    BOOST_REQUIRE_EQUAL(success(), transfer_to_bob(N(carol1111111), SUF));
+    BOOST_REQUIRE(get_lock(N(carol1111111)).is_null());
+    BOOST_REQUIRE(get_restriction(N(carol1111111)).is_null());
+} FC_LOG_AND_RETHROW()
+
+//BD-4643, a lock holding more than the balance of its owner is removed.
+BOOST_FIXTURE_TEST_CASE( general_lock_above_balance_is_removed, fio_system_tester ) try {
+    const int64_t balance = get_balance(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(carol1111111), {period(100, balance), period(200, balance)},
+                                                2 * balance));
+    BOOST_REQUIRE(get_lock(N(carol1111111)).is_null());
+    BOOST_REQUIRE(get_restriction(N(carol1111111)).is_null());
+    BOOST_REQUIRE_EQUAL(success(), transfer_to_bob(N(carol1111111), balance - 2 * SUF));
+    BOOST_REQUIRE_EQUAL(0, get_balance(N(carol1111111)));
+} FC_LOG_AND_RETHROW()
+
+//BD-4643, a lock whose remaining amount disagrees with its payouts has no next_unlock. the amount computed
+//from the periods applies until the next payout records the lock coherent again.
+BOOST_FIXTURE_TEST_CASE( incoherent_general_lock_uses_computed_amount, fio_system_tester ) try {
+    const fc::variants periods{period(100, 10 * SUF), period(200, 20 * SUF)};
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(carol1111111), periods, 30 * SUF));
+    BOOST_REQUIRE_EQUAL(success(), push(config::system_account_name, N(fio.token), N(modgenlocked),
+                                        mvo()("owner", "carol1111111")("periods", periods)
+                                                ("amount", 30 * SUF)("rem_lock_amount", 25 * SUF)("payouts", 0)));
+    auto lock = get_lock(N(carol1111111));
+    const uint32_t timestamp = lock["timestamp"].as<uint32_t>();
+    BOOST_REQUIRE_EQUAL(0, lock["next_unlock"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 200, lock["final_unlock"].as<uint32_t>());
+
+    //30 FIO computed from the periods are locked, not the 25 FIO recorded.
+    BOOST_REQUIRE(is_fio_400(transfer_to_bob(N(carol1111111), get_balance(N(carol1111111)) - 28 * SUF),
+                             "actor", "Funds locked"));
+
+    produce_block(fc::seconds(150));
+    BOOST_REQUIRE_EQUAL(success(), unlocktokens(N(carol1111111)));
+    lock = get_lock(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(1, lock["payouts_performed"].as<uint32_t>());
+    BOOST_REQUIRE_EQUAL(20 * SUF, lock["remaining_lock_amount"].as<int64_t>());
+    BOOST_REQUIRE_EQUAL(timestamp + 200, lock["next_unlock"].as<uint32_t>());
+} FC_LOG_AND_RETHROW()
+
+//a locked and staked account uses its summary, the usable balance is the balance less the locked and staked
+//amounts. the median cpu of a transfer from it and from an account without locks is printed.
+BOOST_FIXTURE_TEST_CASE( staked_account_uses_the_summary, fio_system_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(alice1111111), "alice@alice"));
+    BOOST_REQUIRE_EQUAL(success(), push(config::system_account_name, N(carol1111111), N(voteproducer),
+                                        mvo()("producers", fc::variants{"alice@alice"})("fio_address", "")
+                                                ("actor", "carol1111111")("max_fee", 40 * SUF)));
+    BOOST_REQUIRE_EQUAL(success(), addgenlocked(N(carol1111111), {period(1000, 30 * SUF)}, 30 * SUF));
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.staking), N(carol1111111), N(stakefio),
+                                        mvo()("fio_address", "")("amount", 100 * SUF)("max_fee", 40 * SUF)
+                                                ("tpid", "")("actor", "carol1111111")));
+    const auto restriction = get_restriction(N(carol1111111));
+    BOOST_REQUIRE_EQUAL(30 * SUF, restriction["general_locked"].as<int64_t>());
+    BOOST_REQUIRE_GT(restriction["next_unlock"].as<uint32_t>(), 0);
+
+    //the transfer fee is 2 FIO.
+    const int64_t usable = get_balance(N(carol1111111)) - 130 * SUF - 2 * SUF;
+    BOOST_REQUIRE(is_fio_400(transfer_to_bob(N(carol1111111), usable + 1), "actor", "Funds locked"));
+    BOOST_REQUIRE_EQUAL(success(), transfer_to_bob(N(carol1111111), usable - 20 * SUF));
+    BOOST_REQUIRE_EQUAL(fc::json::to_string(restriction), fc::json::to_string(get_restriction(N(carol1111111))));
+
+    const int64_t staked = median_elapsed([&]() {
+        return push_trace(N(fio.token), N(carol1111111), N(trnsfiopubky),
+                          mvo()("payee_public_key", fio_key(N(bob111111111)))("amount", 1)
+                                  ("max_fee", 40 * SUF)("actor", "carol1111111")("tpid", ""));
+    });
+    const int64_t unlocked = median_elapsed([&]() {
+        return push_trace(N(fio.token), N(bob111111111), N(trnsfiopubky),
+                          mvo()("payee_public_key", fio_key(N(alice1111111)))("amount", 1)
+                                  ("max_fee", 40 * SUF)("actor", "bob111111111")("tpid", ""));
+    });
+    BOOST_TEST_MESSAGE("transfer cpu us, locked and staked: " << staked << ", without locks: " << unlocked);
+} FC_LOG_AND_RETHROW()
+
+//onblock runs once per block, the median cpu of the onblock transactions of a few blocks is printed next to
+//that of an updatepower without changes. both now write only the global singletons that changed, run against
+//a build that writes all of them to compare.
+BOOST_FIXTURE_TEST_CASE( onblock_cpu, fio_system_tester ) try {
+    vector <int64_t> elapsed;
+    auto connection = control->applied_transaction.connect(
+            [&](std::tuple<const transaction_trace_ptr &, const signed_transaction &> t) {
+                const auto &trace = std::get<0>(t);
+                if (!trace->action_traces.empty() && trace->action_traces[0].act.name == N(onblock)) {
+                    elapsed.push_back(trace->elapsed.count());
+                }
+            });
+    produce_blocks(9);
+    connection.disconnect();
+    BOOST_REQUIRE(!elapsed.empty());
+    std::sort(elapsed.begin(), elapsed.end());
+
+    const int64_t updatepower_us = median_elapsed([&]() { return updatepower(N(alice1111111)); });
+    BOOST_TEST_MESSAGE("cpu us, onblock: " << elapsed[elapsed.size() / 2] << ", updatepower: " << updatepower_us);
+} FC_LOG_AND_RETHROW()
+
+//updatepower returns before update_votes when the weight of the voter did not change, the tallies stay as
+//they are. the median cpu of the early exit, of a transfer to the voter that moves the tallies and of a vote
+//reading the memoized votable balances are printed, the early exit must stay cheaper than the transfer.
+BOOST_FIXTURE_TEST_CASE( updatepower_cpu, fio_system_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(alice1111111), "alice@alice"));
+    const int64_t vote = median_elapsed([&]() {
+        return push_trace(config::system_account_name, N(carol1111111), N(voteproducer),
+                          mvo()("producers", fc::variants{"alice@alice"})("fio_address", "")
+                                  ("actor", "carol1111111")("max_fee", 40 * SUF));
+    });
+    const double votes = total_votes(N(alice1111111));
+    BOOST_REQUIRE(votes > 0);
+
+    const int64_t early_exit = median_elapsed([&]() { return updatepower(N(carol1111111)); });
+    BOOST_REQUIRE_EQUAL(votes, total_votes(N(alice1111111)));
+
+    const int64_t transfer = median_elapsed([&]() {
+        return push_trace(N(fio.token), N(bob111111111), N(trnsfiopubky),
+                          mvo()("payee_public_key", fio_key(N(carol1111111)))("amount", SUF)
+                                  ("max_fee", 40 * SUF)("actor", "bob111111111")("tpid", ""));
+    });
+    BOOST_REQUIRE_EQUAL(votes + 5 * SUF, total_votes(N(alice1111111)));
+
+    BOOST_TEST_MESSAGE("updatepower cpu us, early exit: " << early_exit << ", transfer to a voter: " << transfer
+                       << ", voteproducer: " << vote);
+    BOOST_REQUIRE_LT(early_exit, transfer);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
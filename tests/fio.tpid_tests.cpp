@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+//the rewards at which a tpid can be paid, REWARDMAX in fio.tpid.hpp.
+static constexpr uint64_t REWARDMAX = 100 * SUF;
+
+class fio_tpid_tester : public fio_contracts_tester {
+public:
+
+    fio_tpid_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "small@alice"));
+        produce_blocks();
+    }
+
+    action_result updatetpid(const string &tpid, const uint64_t &amount) {
+        return push(N(fio.tpid), N(fio.address), N(updatetpid),
+                    mvo()("tpid", tpid)("owner", "alice1111111")("amount", amount));
+    }
+
+    action_result migrpayable(const account_name &actor, const uint16_t &amount) {
+        return push(N(fio.tpid), actor, N(migrpayable), mvo()("amount", amount)("actor", actor));
+    }
+
+    vector <uint64_t> payable_ids() {
+        vector <uint64_t> ids;
+        for_each_row(N(fio.tpid), N(fio.tpid), N(payabletpids), "payabletpid",
+                     [&](const fc::variant &row) { ids.push_back(row["id"].as<uint64_t>()); });
+        return ids;
+    }
+
+    uint64_t tpid_id(const string &tpid) {
+        uint64_t id = UINT64_MAX;
+        for_each_row(N(fio.tpid), N(fio.tpid), N(tpids), "tpid", [&](const fc::variant &row) {
+            if (row["fioaddress"].as_string() == tpid) id = row["id"].as<uint64_t>();
+        });
+        return id;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_tpid_tests)
+
+//a tpid is queued once its rewards reach REWARDMAX, migrpayable finds the same tpids and adds no duplicate.
+BOOST_FIXTURE_TEST_CASE( migrpayable_queues_payable_tpids, fio_tpid_tester ) try {
+    BOOST_REQUIRE_EQUAL(success(), updatetpid("small@alice", REWARDMAX - 1));
+    BOOST_REQUIRE_EQUAL(success(), updatetpid("alice@alice", REWARDMAX - 1));
+    BOOST_REQUIRE(payable_ids().empty());
+    BOOST_REQUIRE_EQUAL(success(), updatetpid("alice@alice", 1));
+    BOOST_REQUIRE_EQUAL(1, payable_ids().size());
+    BOOST_REQUIRE_EQUAL(tpid_id("alice@alice"), payable_ids()[0]);
+
+    BOOST_REQUIRE(is_fio_400(migrpayable(N(carol1111111), 100), "actor", "Actor not active producer"));
+    BOOST_REQUIRE_EQUAL(success(), register_producer(N(alice1111111), "alice@alice"));
+
+    BOOST_REQUIRE_EQUAL(success(), migrpayable(N(alice1111111), 1));
+    BOOST_REQUIRE_EQUAL(false, get_singleton(N(fio.tpid), N(payablemigr), "payablemigr")["finished"].as<bool>());
+    BOOST_REQUIRE_EQUAL(success(), migrpayable(N(alice1111111), 100));
+    BOOST_REQUIRE_EQUAL(true, get_singleton(N(fio.tpid), N(payablemigr), "payablemigr")["finished"].as<bool>());
+    BOOST_REQUIRE(is_fio_400(migrpayable(N(alice1111111), 100), "migrpayable", "No Work."));
+
+    BOOST_REQUIRE_EQUAL(1, payable_ids().size());
+    BOOST_REQUIRE_EQUAL(tpid_id("alice@alice"), payable_ids()[0]);
+
+    //paying the tpid removes it from the queue.
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.tpid), N(fio.treasury), N(rewardspaid),
+                                        mvo()("tpid", "alice@alice")));
+    BOOST_REQUIRE(payable_ids().empty());
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,190 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "fio.contracts_tester.hpp"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+using namespace fio_contracts;
+
+using mvo = fc::mutable_variant_object;
+
+class fio_treasury_tester : public fio_contracts_tester {
+public:
+
+    fio_treasury_tester() {
+        BOOST_REQUIRE_EQUAL(success(), register_domain(N(alice1111111), "alice"));
+        BOOST_REQUIRE_EQUAL(success(), register_address(N(alice1111111), "alice@alice"));
+        BOOST_REQUIRE_EQUAL(success(), settlerwds());
+        produce_blocks();
+    }
+
+    action_result settlerwds() {
+        return push(N(fio.treasury), N(carol1111111), N(settlerwds), mvo()("actor", "carol1111111"));
+    }
+
+    action_result accrrewards(const account_name &signer, const uint64_t &bpamount, const uint64_t &bppoolamount,
+                              const uint64_t &fdtnamount, const uint64_t &bountyamount = 0) {
+        return push(N(fio.treasury), signer, N(accrrewards),
+                    mvo()("bpamount", bpamount)("bppoolamount", bppoolamount)("fdtnamount", fdtnamount)
+                            ("bountyamount", bountyamount));
+    }
+
+    //the rewards of a treasury reward singleton, 0 when it does not exist.
+    uint64_t rewards(const name &table, const string &type) {
+        const auto row = get_singleton(N(fio.treasury), table, type);
+        return row.is_null() ? 0 : row["rewards"].as<uint64_t>();
+    }
+
+    uint64_t accrued(const string &field) {
+        const auto row = get_singleton(N(fio.treasury), N(rewardaccum), "rewardaccum");
+        return row.is_null() ? 0 : row[field].as<uint64_t>();
+    }
+
+    uint64_t staking_rewards() {
+        const auto row = get_singleton(N(fio.staking), N(staking), "global_staking_state");
+        return row.is_null() ? 0 : row["rewards_token_pool"].as<uint64_t>();
+    }
+
+    uint64_t tpid_rewards(const string &tpid) {
+        uint64_t amount = 0;
+        for_each_row(N(fio.tpid), N(fio.tpid), N(tpids), "tpid", [&](const fc::variant &row) {
+            if (row["fioaddress"].as_string() == tpid) amount = row["rewards"].as<uint64_t>();
+        });
+        return amount;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(fio_treasury_tests)
+
+//a fee without a tpid accrues 70% for the block producers and 5% for the foundation, the reward pools
+//only change when the accrued amounts are settled. 25% goes to staking.
+BOOST_FIXTURE_TEST_CASE( fee_rewards_accrue_until_settled, fio_treasury_tester ) try {
+    const uint64_t bprewards = rewards(N(bprewards), "bpreward");
+    const uint64_t fdtnrewards = rewards(N(fdtnrewards), "fdtnreward");
+    const uint64_t staking = staking_rewards();
+    BOOST_REQUIRE_EQUAL(0, accrued("bprewards"));
+
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.token), N(carol1111111), N(trnsfiopubky),
+                                        mvo()("payee_public_key", fio_key(N(bob111111111)))("amount", SUF)
+                                                ("max_fee", 40 * SUF)("actor", "carol1111111")("tpid", "")));
+    BOOST_REQUIRE_EQUAL(14 * SUF / 10, accrued("bprewards"));
+    BOOST_REQUIRE_EQUAL(0, accrued("bppool"));
+    BOOST_REQUIRE_EQUAL(SUF / 10, accrued("fdtnrewards"));
+    BOOST_REQUIRE_EQUAL(staking + SUF / 2, staking_rewards());
+    BOOST_REQUIRE_EQUAL(bprewards, rewards(N(bprewards), "bpreward"));
+    BOOST_REQUIRE_EQUAL(fdtnrewards, rewards(N(fdtnrewards), "fdtnreward"));
+
+    BOOST_REQUIRE_EQUAL(success(), settlerwds());
+    BOOST_REQUIRE_EQUAL(bprewards + 14 * SUF / 10, rewards(N(bprewards), "bpreward"));
+    BOOST_REQUIRE_EQUAL(fdtnrewards + SUF / 10, rewards(N(fdtnrewards), "fdtnreward"));
+    BOOST_REQUIRE_EQUAL(0, accrued("bprewards"));
+    BOOST_REQUIRE_EQUAL(0, accrued("fdtnrewards"));
+    BOOST_REQUIRE(is_fio_400(settlerwds(), "settlerwds", "No work."));
+} FC_LOG_AND_RETHROW()
+
+//a bucket fee with a tpid splits into 60% bucket pool, 5% foundation, 25% staking and 10% tpid, plus the
+//40% bounty for the tpid, which is minted to the treasury when settled. the shares add up to the fee.
+BOOST_FIXTURE_TEST_CASE( bucket_fee_with_tpid_splits_the_fee, fio_treasury_tester ) try {
+    const uint64_t bppool = rewards(N(bpbucketpool), "bucketpool");
+    const uint64_t fdtnrewards = rewards(N(fdtnrewards), "fdtnreward");
+    const uint64_t staking = staking_rewards();
+    const uint64_t tpid = tpid_rewards("alice@alice");
+    const uint64_t minted = get_singleton(N(fio.tpid), N(bounties), "bounty")["tokensminted"].as<uint64_t>();
+    const int64_t treasury = get_balance(N(fio.treasury));
+
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.address), N(bob111111111), N(regdomain),
+                                        mvo()("fio_domain", "bob")("owner_fio_public_key", "")
+                                                ("max_fee", 800 * SUF)("actor", "bob111111111")
+                                                ("tpid", "alice@alice")));
+    BOOST_REQUIRE_EQUAL(0, accrued("bprewards"));
+    BOOST_REQUIRE_EQUAL(24 * SUF, accrued("bppool"));
+    BOOST_REQUIRE_EQUAL(2 * SUF, accrued("fdtnrewards"));
+    BOOST_REQUIRE_EQUAL(staking + 10 * SUF, staking_rewards());
+    BOOST_REQUIRE_EQUAL(tpid + 4 * SUF + 16 * SUF, tpid_rewards("alice@alice"));
+    BOOST_REQUIRE_EQUAL(minted + 16 * SUF,
+                        get_singleton(N(fio.tpid), N(bounties), "bounty")["tokensminted"].as<uint64_t>());
+    BOOST_REQUIRE_EQUAL(16 * SUF, accrued("bounty"));
+    BOOST_REQUIRE_EQUAL(treasury + 40 * SUF, get_balance(N(fio.treasury)));
+    BOOST_REQUIRE_EQUAL(40 * SUF, accrued("bppool") + accrued("fdtnrewards") + 10 * SUF + 4 * SUF);
+
+    BOOST_REQUIRE_EQUAL(success(), settlerwds());
+    BOOST_REQUIRE_EQUAL(bppool + 24 * SUF, rewards(N(bpbucketpool), "bucketpool"));
+    BOOST_REQUIRE_EQUAL(fdtnrewards + 2 * SUF, rewards(N(fdtnrewards), "fdtnreward"));
+    BOOST_REQUIRE_EQUAL(0, accrued("bounty"));
+    BOOST_REQUIRE_EQUAL(treasury + 40 * SUF + 16 * SUF, get_balance(N(fio.treasury)));
+} FC_LOG_AND_RETHROW()
+
+//accrued and settled amounts end in the same pools as the bprewdupdate, bppoolupdate and fdtnrwdupdat
+//actions they replace.
+BOOST_FIXTURE_TEST_CASE( settled_rewards_match_the_direct_updates, fio_treasury_tester ) try {
+    const uint64_t bprewards = rewards(N(bprewards), "bpreward");
+    const uint64_t bppool = rewards(N(bpbucketpool), "bucketpool");
+    const uint64_t fdtnrewards = rewards(N(fdtnrewards), "fdtnreward");
+
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.treasury), N(fio.address), N(bprewdupdate), mvo()("amount", 7)));
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.treasury), N(fio.address), N(bppoolupdate), mvo()("amount", 11)));
+    BOOST_REQUIRE_EQUAL(success(), push(N(fio.treasury), N(fio.address), N(fdtnrwdupdat), mvo()("amount", 13)));
+    const uint64_t direct_bp = rewards(N(bprewards), "bpreward") - bprewards;
+    const uint64_t direct_pool = rewards(N(bpbucketpool), "bucketpool") - bppool;
+    const uint64_t direct_fdtn = rewards(N(fdtnrewards), "fdtnreward") - fdtnrewards;
+
+    BOOST_REQUIRE_EQUAL(success(), accrrewards(N(fio.address), 7, 11, 13));
+    BOOST_REQUIRE_EQUAL(success(), settlerwds());
+    BOOST_REQUIRE_EQUAL(bprewards + 2 * direct_bp, rewards(N(bprewards), "bpreward"));
+    BOOST_REQUIRE_EQUAL(bppool + 2 * direct_pool, rewards(N(bpbucketpool), "bucketpool"));
+    BOOST_REQUIRE_EQUAL(fdtnrewards + 2 * direct_fdtn, rewards(N(fdtnrewards), "fdtnreward"));
+} FC_LOG_AND_RETHROW()
+
+//the inline actions of a fee, printed with --log_level=message. a fee without a tpid sends the fee transfer,
+//updatepower, accrrewards and incgrewards. a tpid adds rewardtpid, the bounty is no longer minted per fee.
+//the staking share stays inline so stakefio and unstakefio see every reward, and rewardtpid stays inline
+//because it sets the auto proxy of the payer in the same transaction.
+BOOST_FIXTURE_TEST_CASE( inline_actions_per_fee, fio_treasury_tester ) try {
+    const auto notpid = push_trace(N(fio.token), N(carol1111111), N(trnsfiopubky),
+                                   mvo()("payee_public_key", fio_key(N(bob111111111)))("amount", SUF)
+                                           ("max_fee", 40 * SUF)("actor", "carol1111111")("tpid", ""));
+    const auto tpid = push_trace(N(fio.token), N(carol1111111), N(trnsfiopubky),
+                                 mvo()("payee_public_key", fio_key(N(bob111111111)))("amount", SUF)
+                                         ("max_fee", 40 * SUF)("actor", "carol1111111")("tpid", "alice@alice"));
+    BOOST_TEST_MESSAGE("actions per fee, without a tpid: " << notpid->action_traces.size()
+                       << ", with a tpid: " << tpid->action_traces.size());
+
+    for (const auto &trace : {notpid, tpid}) {
+        BOOST_REQUIRE_EQUAL(1, count_actions(trace, N(accrrewards)));
+        BOOST_REQUIRE_EQUAL(1, count_actions(trace, N(incgrewards)));
+        BOOST_REQUIRE_EQUAL(0, count_actions(trace, N(mintfio)));
+        BOOST_REQUIRE_EQUAL(0, count_actions(trace, N(bprewdupdate)));
+        BOOST_REQUIRE_EQUAL(0, count_actions(trace, N(fdtnrwdupdat)));
+    }
+    BOOST_REQUIRE_EQUAL(0, count_actions(notpid, N(rewardtpid)));
+    BOOST_REQUIRE_EQUAL(1, count_actions(tpid, N(rewardtpid)));
+} FC_LOG_AND_RETHROW()
+
+//each share may only be accrued by the accounts allowed to call the action it replaces.
+BOOST_FIXTURE_TEST_CASE( accrrewards_restricts_each_share, fio_treasury_tester ) try {
+    BOOST_REQUIRE_EQUAL(wasm_assert_msg("missing required authority of fio.address, fio.token, fio.staking, "
+                                        "fio.fee, fio.treasury, fio.oracle fio.perms or fio.reqobt"),
+                        accrrewards(N(alice1111111), 0, 0, 1));
+    //fio.staking may update the producer rewards and the foundation, not the bucket pool.
+    BOOST_REQUIRE_EQUAL(success(), accrrewards(N(fio.staking), 1, 0, 1));
+    BOOST_REQUIRE_EQUAL(wasm_assert_msg("missing required authority of eosio, fio.address, fio.treasury, "
+                                        "fio.token, fio.oracle fio.perms or fio.reqobt"),
+                        accrrewards(N(fio.staking), 0, 1, 0));
+    //fio.fee may not update the bucket pool either.
+    BOOST_REQUIRE_EQUAL(wasm_assert_msg("missing required authority of eosio, fio.address, fio.treasury, "
+                                        "fio.token, fio.oracle fio.perms or fio.reqobt"),
+                        accrrewards(N(fio.fee), 0, 1, 0));
+    //only fio.treasury may accrue a bounty to mint.
+    BOOST_REQUIRE_EQUAL(error("missing authority of fio.treasury"), accrrewards(N(fio.address), 0, 0, 1, 1));
+    BOOST_REQUIRE_EQUAL(1, accrued("bprewards"));
+    BOOST_REQUIRE_EQUAL(0, accrued("bppool"));
+    BOOST_REQUIRE_EQUAL(1, accrued("fdtnrewards"));
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()